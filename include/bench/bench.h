@@ -0,0 +1,85 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <config.h>
+
+// 延迟统计结果（微秒）
+typedef struct {
+    int count;
+    uint64_t min_us;
+    uint64_t avg_us;
+    uint64_t p50_us;
+    uint64_t p90_us;
+    uint64_t p99_us;
+    uint64_t max_us;
+} bench_latency_t;
+
+/**
+ * @brief 计算一组延迟样本的统计值（会对样本原地排序）
+ * @param samples 延迟样本（微秒）
+ * @param count 样本数量
+ * @param result 输出统计结果
+ */
+void bench_latency_compute(uint64_t *samples, int count, bench_latency_t *result);
+
+// 打印延迟统计结果
+void bench_latency_print(const char *label, const bench_latency_t *result);
+
+/**
+ * @brief 舵机控制闭环延迟基准测试
+ *
+ * 从记录文件读取 6050_date 指令流，经由本地MQTT服务器按原始时间间隔发布，
+ * 设备端照常订阅并调用 parse_json_and_control 驱动当前舵机后端，
+ * 统计从指令发布到舵机到位的延迟。
+ *
+ * 记录文件每行一条指令，格式为 "<时间戳毫秒> <JSON>" 或仅 "<JSON>"，
+ * 以 # 开头的行为注释。
+ * 先后以"控制与视频共用连接"和"独立控制连接"两种方式各回放一轮，分别输出延迟统计。
+ * @param path 指令记录文件路径
+ * @param broker MQTT服务器地址
+ * @param video_load 是否在视频连接上同时连续发布整帧消息，模拟上行带宽饱和
+ * @return int 0-成功，负数-失败
+ */
+int bench_engine_run(const char *path, const char *broker, bool video_load);
+
+/**
+ * @brief 切片并行缩放基准测试
+ *
+ * 用合成的 640x480 YUVJ422P 图像（与MJPEG解码输出一致）测试 1~max_workers 个切片线程
+ * 缩放到 240x240 RGB565 的单帧耗时与加速比，并校验输出与单线程结果逐字节一致。
+ * @param max_workers 最大切片线程数
+ * @param iterations 每种线程数下的迭代次数
+ * @return int 0-成功，负数-失败
+ */
+int bench_scale_run(int max_workers, int iterations);
+
+/**
+ * @brief MQTT 5 功能测试
+ *
+ * 先用进程内只支持 3.1.1 的模拟服务器验证两种回退路径：
+ * 以 CONNACK 返回码1拒绝 MQTT 5 连接，以及收到 MQTT 5 CONNECT 后直接断开TCP，
+ * 两种情况下连接都应以 3.1.1 建立并可发布，且只有前者被记住为只支持 3.1.1。
+ * 再连接真实服务器，由观察端以 MQTT 5 订阅，检查图像消息的主题别名、消息过期时间
+ * 与内容类型，以及普通消息不带内容类型。
+ * @param broker 支持 MQTT 5 的服务器地址
+ * @return int 0-全部通过，负数-有检查未通过
+ */
+int bench_mqtt5_run(const char *broker);
+
+/**
+ * @brief 启动期间终止信号回归检查：delay_ms 毫秒后向本进程发送 SIGINT
+ *
+ * 在注册信号处理后调用，之后照常启动，用于检查舵机、摄像头、MQTT 初始化期间
+ * 收到终止信号时进程能否退出（不会卡在监听线程的 epoll_wait）。例如：
+ *   for ms in 0 20 50 100 200 500 1000 2000; do
+ *       timeout 15 ./s5p6818_device_example --engine=sim --bench-shutdown=$ms || echo "$ms 未退出";
+ *   done
+ * @param delay_ms 延迟毫秒数
+ * @return int 0-成功，负数-创建线程失败
+ */
+int bench_shutdown_arm(int delay_ms);
+
+#endif
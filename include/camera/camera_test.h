@@ -11,21 +11,76 @@ typedef struct {
     char *device;           // 摄像头设备路径，如 "/dev/video0"
     int width;              // 输出图像宽度
     int height;             // 输出图像高度
+    int capture_width;      // 采集分辨率宽度（摄像头输出）
+    int capture_height;     // 采集分辨率高度
     int fps;                // 目标帧率
+    int capture_fps;        // 摄像头采集帧率
+    int crop_width;         // 电子云台裁剪窗口宽度，0为不裁剪（整幅画面）
+    int crop_height;        // 电子云台裁剪窗口高度
+    int roi_width;          // 注视区域宽度（输出图像像素），0为不启用注视区域编码
+    int roi_height;         // 注视区域高度
+    int roi_scale;          // 注视区域编码时外围图像的缩小倍数
+    int scale_workers;      // 格式转换/缩放的切片线程数，1为单线程
+    int decode_threads;     // 解码线程数，0为由FFmpeg自动选择
+    int pixel_format;       // 输出像素格式（pixel_format_t）
+    bool dither;            // 降低位深时是否抖动
+    bool grab_latest;       // 最新帧抓取：后台持续取包只保留最新一个，取帧时才解码
+    bool fast_start;        // 快速启动：不探测流信息，按采集参数与 FASTSTART_PIX_FMT 配置解码与缩放
     bool is_initialized;    // 初始化状态标志
 } camera_config_t;
 
+// 采集统计
+typedef struct {
+    uint64_t decoded;       // 已解码帧数
+    uint64_t skipped;       // 未解码即被更新数据包替换的数据包数（最新帧抓取模式）
+    int64_t last_age_us;    // 最近一帧解码完成时距摄像头采集的时间，-1为未知
+    int64_t max_age_us;     // 最大帧龄
+    int64_t total_age_us;   // 帧龄累加（计算平均值）
+    uint64_t aged;          // 有帧龄的帧数
+} camera_stats_t;
+
+/**
+ * 注视区域编码的一帧布局
+ * camera_get_frame 输出 = [调色板] + 外围图像（periph_width*periph_height，配置的像素格式）
+ *                        + 注视区域图像（width*height，RGB565）
+ */
+typedef struct {
+    int x, y;               // 注视区域在输出图像中的左上角
+    int width, height;      // 注视区域大小
+    int periph_width;       // 外围图像宽度（输出宽度 / roi_scale）
+    int periph_height;      // 外围图像高度
+} camera_roi_t;
+
 // 初始化摄像头，设置参数并打开设备
 int camera_init(camera_config_t *config);
 
 /**
- * @brief 从摄像头获取一帧图像，转换为240*240*16位RGB格式
- * @param buffer 输出参数，函数内部会分配内存，调用者负责释放
+ * @brief 运行中修改摄像头配置，只重建受影响的阶段
+ *
+ * 采集分辨率/设备/解码线程/抓取模式变化时重新打开设备；输出分辨率、像素格式、抖动或切片数变化时
+ * 只重建缩放上下文与输出缓冲区（裁剪窗口大小同样如此）。须在调用 camera_get_frame 的线程中调用。
+ * @return int 0-成功，-1-失败（已恢复原配置），-2-失败且原配置也无法恢复（摄像头已关闭，
+ *             再次调用本函数会重新打开）
+ */
+int camera_reconfigure(camera_config_t *config);
+
+/**
+ * @brief 从摄像头获取一帧图像，转换为配置的分辨率与像素格式（默认240*240*16位RGB565）
+ * @param buffer 输出参数，函数内部会分配内存，调用者负责释放；pal8 格式时前 768 字节为调色板
  * @param size 输出参数，返回buffer的大小
  * @return int 0-成功，负数-失败
  */
 int camera_get_frame(unsigned char **buffer, long *size);
 
+/**
+ * @brief 最近一次 camera_get_frame 输出的注视区域布局（与 camera_get_frame 在同一线程调用）
+ * @return bool true-该帧使用注视区域编码，false-普通整帧
+ */
+bool camera_get_roi(camera_roi_t *roi);
+
+// 获取采集统计（帧龄、跳过的数据包数）
+void camera_get_stats(camera_stats_t *stats);
+
 // 关闭摄像头，释放资源
 void camera_deinit(void);
 
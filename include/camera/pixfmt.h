@@ -0,0 +1,79 @@
+#ifndef PIXFMT_H
+#define PIXFMT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <libavutil/pixfmt.h>
+
+/**
+ * 输出像素格式，数值即帧头中的 pixel_format 字段，不可改动已有取值
+ * 每行按字节对齐，GRAY4 每字节两个像素，高4位为左侧像素；
+ * PAL8 的图像数据前附带 256 项 RGB888 调色板。
+ */
+typedef enum {
+    PIXEL_FORMAT_RGB565 = 0,  // 16位，默认
+    PIXEL_FORMAT_RGB332 = 1,  // 8位，高3位R、中3位G、低2位B
+    PIXEL_FORMAT_GRAY8  = 2,  // 8位灰度
+    PIXEL_FORMAT_GRAY4  = 3,  // 4位灰度
+    PIXEL_FORMAT_PAL8   = 4,  // 8位索引色，自适应调色板
+    PIXEL_FORMAT_COUNT
+} pixel_format_t;
+
+// 调色板项数
+#define PIXFMT_PALETTE_SIZE 256
+
+// 像素格式转换上下文
+typedef struct {
+    pixel_format_t format;
+    int width, height;
+    bool dither;                  // 是否启用有序抖动
+    uint32_t frame_count;
+
+    // 自适应调色板（仅 PAL8 使用）
+    uint8_t palette[PIXFMT_PALETTE_SIZE * 3]; // RGB888
+    int palette_used;             // 有效调色板项数
+    uint8_t *lut;                 // RGB444 -> 调色板索引
+    uint16_t *bins;               // 每像素的 RGB444 值
+    uint32_t *hist;               // RGB444 直方图及分量累加（更新调色板时使用）
+    uint8_t *rows[3];             // 单行量化结果
+} pixfmt_ctx;
+
+// 获取格式名称
+const char *pixfmt_name(pixel_format_t format);
+
+// 按名称查找格式，未知名称返回 -1
+int pixfmt_from_name(const char *name);
+
+// 缩放阶段应输出的中间格式
+enum AVPixelFormat pixfmt_scaler_format(pixel_format_t format);
+
+// 每行字节数
+size_t pixfmt_row_bytes(pixel_format_t format, int width);
+
+// 帧数据前附带的调色板字节数
+size_t pixfmt_palette_bytes(pixel_format_t format);
+
+// 一帧数据总字节数（调色板 + 图像）
+size_t pixfmt_frame_size(pixel_format_t format, int width, int height);
+
+/**
+ * @brief 初始化像素格式转换
+ * @param dither 是否在降低位深时使用 8x8 有序抖动
+ * @return int 0-成功，负数-失败
+ */
+int pixfmt_init(pixfmt_ctx *ctx, pixel_format_t format, int width, int height, bool dither);
+
+/**
+ * @brief 把缩放输出（pixfmt_scaler_format 格式）转换为目标格式
+ * @param src 缩放输出的各平面
+ * @param src_stride 各平面行跨度
+ * @param dst 输出缓冲区，大小为 pixfmt_frame_size
+ * @return int 0-成功，负数-失败
+ */
+int pixfmt_convert(pixfmt_ctx *ctx, uint8_t *const src[], const int src_stride[], uint8_t *dst);
+
+// 释放资源
+void pixfmt_destroy(pixfmt_ctx *ctx);
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef SCALER_H
+#define SCALER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <libswscale/swscale.h>
+#include <libavutil/pixfmt.h>
+
+// 最大切片（工作线程）数量，S5P6818 为8核
+#define SCALER_MAX_WORKERS 8
+// 切片上下各多算的输出行数，保证切片边界处的滤波结果与整帧一致
+#define SCALER_SLICE_MARGIN 4
+
+// 单个水平切片
+typedef struct {
+    struct SwsContext *sws;   // 本切片独占的缩放上下文
+    int dst_y, dst_h;         // 负责输出的行范围
+    int ext_y, ext_h;         // 含重叠边距的输出行范围
+    int src_y, src_h;         // 对应的输入行范围
+    uint8_t *scratch[4];      // 含边距的临时输出（仅多切片时使用）
+    int scratch_stride[4];
+} scaler_slice_t;
+
+struct scaler_ctx;
+
+// 工作线程参数
+typedef struct {
+    struct scaler_ctx *ctx;
+    int index;
+} scaler_worker_t;
+
+// 切片并行缩放上下文：常驻工作线程池，每个切片一个 SwsContext
+typedef struct scaler_ctx {
+    int src_w, src_h;
+    enum AVPixelFormat src_fmt;
+    int dst_w, dst_h;
+    enum AVPixelFormat dst_fmt;
+
+    int slice_count;                              // 实际切片数
+    scaler_slice_t slices[SCALER_MAX_WORKERS];
+    pthread_t threads[SCALER_MAX_WORKERS];        // 切片1..n-1 的工作线程，切片0由调用线程处理
+    scaler_worker_t workers[SCALER_MAX_WORKERS];
+    int thread_count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start_cond;
+    pthread_cond_t done_cond;
+    unsigned int generation;                      // 任务代数，每次 scaler_run 加一
+    int pending;                                  // 未完成的工作线程切片数
+    bool stop;
+
+    // 当前任务
+    const uint8_t *crop_src[4];                   // 按裁剪起点偏移后的输入平面指针
+    const uint8_t *const *src;
+    const int *src_stride;
+    uint8_t *const *dst;
+    const int *dst_stride;
+} scaler_ctx;
+
+/**
+ * @brief 初始化切片并行缩放上下文
+ * @param workers 期望的切片（线程）数，按行对齐要求可能减少，1 表示单线程
+ * @return int 0-成功，负数-失败
+ */
+int scaler_init(scaler_ctx *ctx,
+                int src_w, int src_h, enum AVPixelFormat src_fmt,
+                int dst_w, int dst_h, enum AVPixelFormat dst_fmt,
+                int workers);
+
+// 对一帧执行格式转换与缩放，输出与单线程 sws_scale 一致
+int scaler_run(scaler_ctx *ctx,
+               const uint8_t *const src[], const int src_stride[],
+               uint8_t *const dst[], const int dst_stride[]);
+
+/**
+ * @brief 从输入图像的 (x, y) 处取 src_w*src_h 的窗口缩放，只偏移平面指针不复制
+ * 起点按色度采样向下对齐；调用者保证窗口不超出输入图像
+ */
+int scaler_run_at(scaler_ctx *ctx,
+                  const uint8_t *const src[], const int src_stride[], int x, int y,
+                  uint8_t *const dst[], const int dst_stride[]);
+
+// 停止工作线程并释放资源
+void scaler_destroy(scaler_ctx *ctx);
+
+#endif
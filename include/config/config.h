@@ -15,19 +15,139 @@
 // 发布主题名称，上传数据
 #define TOPIC_PUB         "6818_image" // 发布的主题，通常为上行数据
 
+// ===================== 丢帧检测配置 =====================
+// 视频帧发布服务质量等级：0 不等待PUBACK，过时的帧不重传；stream_config 的 qos 可修改
+#define VIDEO_QOS         0      // 接收端按 frame_id 检测缺口，用 refresh 指令请求刷新
+// 收到刷新请求后，下一帧以该服务质量等级发送，保证接收端得到一幅完整画面
+#define REFRESH_QOS       1
+// 两次刷新之间的最短间隔（毫秒），多个接收端同时请求时合并
+#define REFRESH_MIN_INTERVAL_MS 200
+// 记录最近发布的帧ID数，用于区分网络丢失与设备主动丢帧
+#define REFRESH_HISTORY   256
+
+// ===================== 控制连接配置 =====================
+// 是否为舵机指令单独建立MQTT连接：1=独立连接，0=与视频共用一个连接（可用命令行 --control=split 开启）
+// 独立连接时指令不会排在视频消息之后，但会多占用一个服务器会话（客户端ID为 CONTROL_CLIENT_ID，
+// 需服务器ACL允许），且以 CONTROL_QOS 订阅，默认关闭
+#define CONTROL_SPLIT_ENABLE 0
+// 独立控制连接的客户端ID，需与视频连接不同
+#define CONTROL_CLIENT_ID "s5p6818_Client_ctrl"
+// 独立控制连接的订阅服务质量等级
+#define CONTROL_QOS       0 // 指令由后续指令覆盖，0 避免确认往返
+// 独立控制连接的保活时间（秒）
+#define CONTROL_KEEPALIVE 2 // 控制链路断线需尽快发现
+
 // ===================== 重连配置 =====================
-// MQTT断线重连间隔（毫秒）
-#define RECONNECT_INTERVAL 5000  // 每隔5秒尝试重连一次
-// 最大重连尝试次数，超过后放弃重连
-#define MAX_RECONNECT_ATTEMPTS 10 // 0为无限重试，建议设置上限防止死循环
+// MQTT服务器列表，逗号分隔，按顺序故障切换（首个为主服务器）
+#define BROKER_LIST       DEFAULT_ADDRESS // 如 DEFAULT_ADDRESS ",tcp://192.168.1.96:1883"
+// 服务器列表最多地址数
+#define MQTT_MAX_BROKERS  4
+// MQTT保活时间（秒），决定Wi-Fi中断后多快发现断线
+#define MQTT_KEEPALIVE    5
+// 单次连接超时时间（秒），Paho 的 connectTimeout 以秒为单位
+#define MQTT_CONNECT_TIMEOUT 2
+// 断线后首次重试立即进行，之后的退避间隔从该值开始倍增（毫秒）
+#define RECONNECT_INITIAL_MS 200
+// MQTT断线重连最大退避间隔（毫秒）
+#define RECONNECT_INTERVAL 5000  // 退避间隔倍增到5秒后不再增加，实际间隔带50%随机抖动
+// 同一服务器连续重连失败次数达到该值后切换到列表中的下一台
+#define MAX_RECONNECT_ATTEMPTS 3 // 0为不切换，始终重试当前服务器
+
+// ===================== MQTT 5 配置 =====================
+// 是否优先使用 MQTT 5：服务器不支持时自动回退到 3.1.1，可用命令行 --mqtt5 覆盖
+#define MQTT5_ENABLE      1
+// 视频消息过期时间（秒），服务器不再向慢速订阅者转发超过该时间的旧帧；0为不过期
+#define MQTT5_MESSAGE_EXPIRY 1
+// 每条连接最多使用的主题别名数（实际取服务器 CONNACK 中 Topic Alias Maximum 与该值的较小者）
+#define MQTT5_TOPIC_ALIAS_MAX 4
+// 视频消息的内容类型，接收端据此区分帧头格式，无需探测魔数
+#define MQTT5_CONTENT_TYPE_FRAME "6818/frame"  // frame_header_t + RGB565
+#define MQTT5_CONTENT_TYPE_CHUNK "6818/chunk"  // frame_chunk_header_t + 调色板 + 图像数据
 
 // ===================== 视频配置 =====================
 // 摄像头设备文件路径
 #define CAMERA_DEVICE     "/dev/video0"
+// 输出图像分辨率，可用 stream_config 命令在运行中修改
+#define FRAME_WIDTH       240
+#define FRAME_HEIGHT      240
+// 摄像头采集分辨率
+#define CAPTURE_WIDTH     640
+#define CAPTURE_HEIGHT    480
+// 摄像头采集帧率（设备输出帧率，可高于 TARGET_FPS）
+#define CAPTURE_FPS       30
+// 最新帧抓取：独立线程持续取出数据包只保留最新一个，发布需要帧时才解码，可用命令行 --grab 覆盖
+#define GRAB_LATEST_ENABLE 1     // 0=按顺序读取并解码每个数据包；仅对MJPEG等帧内编码生效
+// 最新帧抓取的读取线程遇到 EAGAIN（设备暂无数据）时的等待时间（微秒）
+#define DRAIN_RETRY_US    1000
+// 电子云台：从采集画面中裁取窗口再缩放到输出分辨率，窗口随角度指令立即移动，可用命令行 --eptz 覆盖
+#define EPTZ_ENABLE       0      // 1=启用，0=整幅采集画面缩放输出
+// 裁剪窗口大小（采集图像像素），越小放大倍数越高、可平移范围越大；stream_config 可修改
+#define EPTZ_CROP_WIDTH   360
+#define EPTZ_CROP_HEIGHT  360
+// 每度角度对应的采集图像像素数（约为 采集宽度 / 镜头水平视场角），负数表示方向相反
+#define EPTZ_PX_PER_DEG_PAN  10.0  // 水平，对应 angle_z
+#define EPTZ_PX_PER_DEG_TILT 10.0  // 垂直，对应 angle_y
+// 电机转速估算值（度/秒），用于估算机械角度
+#define EPTZ_SLEW_DEG_S   120.0
 // 目标视频帧率（FPS），影响视频流畅度与带宽
 #define TARGET_FPS        10     // 建议5~30，过高占用带宽
 // 最大连续获取帧失败次数，超过后暂停一段时间
 #define MAX_FAILURES      5      // 防止摄像头异常导致死循环
+// 格式转换/缩放的切片线程数，可用命令行 --scale-workers 覆盖
+#define SCALE_WORKERS     4      // 1为单线程，最大8
+// 解码线程数，0为由FFmpeg按CPU核数自动选择
+#define DECODE_THREADS    0
+// 解码帧线程：仅作为吞吐选项，CPU 无法按切片线程实时解码时提高帧率，但每帧增加 线程数-1 帧的延迟
+#define DECODE_FRAME_THREADS 0   // 0=只用切片线程（默认，不增加延迟），1=同时启用帧线程；最新帧抓取模式下不生效
+// 解码线程类型（FFmpeg thread_type）
+#define DECODE_THREAD_TYPE (DECODE_FRAME_THREADS ? (FF_THREAD_FRAME | FF_THREAD_SLICE) : FF_THREAD_SLICE)
+// 输出像素格式：rgb565、rgb332、gray8、gray4、pal8，可用命令行 --pixel-format 覆盖
+#define PIXEL_FORMAT      "rgb565" // 弱网时 rgb332/gray8/pal8 减半、gray4 减为1/4
+// 降低位深时是否使用有序抖动，减轻色带
+#define PIXEL_DITHER      1
+// 注视区域编码：中心区域全分辨率 RGB565，外围整幅画面缩小后按 PIXEL_FORMAT 发送，可用命令行 --fovea 覆盖
+#define FOVEA_ENABLE      0      // 1=启用，0=整幅画面同一分辨率与格式
+// 注视区域大小（输出图像像素），stream_config 的 roi_width/roi_height 可修改
+#define FOVEA_ROI_WIDTH   96
+#define FOVEA_ROI_HEIGHT  96
+// 外围图像缩小倍数（宽高各除以该值），接收端放大后再叠加注视区域
+#define FOVEA_PERIPH_SCALE 2     // 240x240 rgb565 时每帧约为整帧的 41%，外围用 rgb332 约 28%
+// 超过该时间（毫秒）未收到 gaze 指令时注视区域回到画面中心
+#define FOVEA_GAZE_TIMEOUT_MS 2000
+// pal8 格式每隔多少帧重新生成一次自适应调色板
+#define PALETTE_UPDATE_FRAMES 30
+// 发送队列深度，队列满时丢弃最旧的帧
+#define SENDQ_DEPTH       2
+// 每帧从采集起允许的最大发送延迟（毫秒），超过则优先发送更新的帧
+#define FRAME_DEADLINE_MS 200    // 头部跟随观看时新鲜帧比完整积压更有价值
+// 是否启用分片传输，接收端可逐行带显示，降低首像素延迟与接收端内存占用
+#define CHUNK_ENABLE      0      // 1=分片发送（frame_chunk_header_t），0=整帧发送（frame_header_t）
+// 每个分片的目标字节数，按整行向下取整
+#define CHUNK_SIZE        (12 * 1024) // 建议8~16KB
+// 分片发送时最多同时等待确认的分片数
+#define CHUNK_MAX_INFLIGHT 4
+
+// ===================== 线程放置配置 =====================
+// 是否启用线程调度策略/CPU亲和性配置，权限不足时自动降级为普通调度
+#define THREAD_PROFILE_ENABLE   1
+// 是否锁定进程内存（mlockall），避免缺页导致控制线程抖动，需要 CAP_IPC_LOCK
+#define THREAD_MLOCKALL         0
+// 舵机指令处理线程：实时调度，独占CPU1，避开解码负载
+#define THREAD_CONTROL_POLICY   SCHED_FIFO
+#define THREAD_CONTROL_PRIORITY 80       // 实时优先级 1~99
+#define THREAD_CONTROL_CPUS     0x02     // CPU亲和性位掩码，0为不限制
+// MQTT连接维护线程：普通调度，与控制线程同核（大部分时间在睡眠）
+#define THREAD_LISTEN_POLICY    SCHED_OTHER
+#define THREAD_LISTEN_PRIORITY  0        // SCHED_OTHER 下为 nice 值
+#define THREAD_LISTEN_CPUS      0x02
+// 采集解码线程：普通调度，使用其余CPU
+#define THREAD_CAPTURE_POLICY   SCHED_OTHER
+#define THREAD_CAPTURE_PRIORITY 0
+#define THREAD_CAPTURE_CPUS     0xFC
+// 视频发布线程：普通调度，使用其余CPU
+#define THREAD_PUBLISH_POLICY   SCHED_OTHER
+#define THREAD_PUBLISH_PRIORITY 0
+#define THREAD_PUBLISH_CPUS     0xFC
 
 // ===================== 舵机配置 =====================
 // 舵机设备文件路径
@@ -36,5 +156,95 @@
 #define DEG_UNIT          1.8    // 常见步进电机为1.8度/步
 // 舵机控制指令间的延迟（毫秒）
 #define DELAY_MS          50     // 适当延迟防止过载
+// 默认舵机后端，可用命令行 --engine 覆盖
+#define ENGINE_BACKEND    "hw"   // hw=真实驱动，sim=模拟舵机（开发机调试用）
+// 模拟舵机：每步耗时（微秒）
+#define ENGINE_SIM_STEP_US    2000
+// 模拟舵机：最大转速（度/秒）
+#define ENGINE_SIM_SPEED_DPS  300.0
+// 模拟舵机：ioctl调用本身的延迟（微秒）
+#define ENGINE_SIM_IOCTL_US   150
+
+// ===================== 基准测试配置 =====================
+// 基准测试使用的本地MQTT服务器地址
+#define BENCH_BROKER      "tcp://127.0.0.1:1883"
+// 基准测试发送端客户端ID
+#define BENCH_CLIENT_ID   "s5p6818_bench"
+// 基准测试设备端客户端ID（视频/控制连接），与正在运行的设备不同，避免互相踢下线
+#define BENCH_DEVICE_CLIENT_ID  "s5p6818_bench_dev"
+#define BENCH_CONTROL_CLIENT_ID "s5p6818_bench_ctrl"
+// 指令记录文件中未带时间戳的行之间的默认间隔（毫秒）
+#define BENCH_INTERVAL_MS 20
+// 单次基准测试最多回放的指令条数
+#define BENCH_MAX_COMMANDS 10000
+// MQTT 5 测试：图像消息主题与普通消息主题，不使用正式主题，避免干扰正在运行的设备
+#define BENCH_MQTT5_TOPIC       "6818_bench_frame"
+#define BENCH_MQTT5_PLAIN_TOPIC "6818_bench_plain"
+// MQTT 5 测试：发布的图像消息条数，第2条起只带主题别名
+#define BENCH_MQTT5_FRAMES      5
+// MQTT 5 测试：消息过期时间（秒），取较大值保证测试期间不过期
+#define BENCH_MQTT5_EXPIRY      30
+
+// ===================== 本地录像配置 =====================
+// 是否启用本地环形录像，断网期间的画面仍可事后回放
+#define RECORDER_ENABLE     0      // 1=启用，0=关闭
+// 环形录像文件路径，建议放在SD卡等本地存储上
+#define RECORDER_PATH       "/mnt/sdcard/s5p6818_ring.bin"
+// 环形文件槽位数，每个槽位保存一帧
+#define RECORDER_SLOT_COUNT 600    // 10fps下约保存最近60秒
+// 每个槽位字节数，需大于帧头+布局+单帧图像大小（240x240 RGB565 约113KB）
+#define RECORDER_SLOT_SIZE  (128 * 1024)
+// 每批写入帧数，合并为一次大块顺序写
+#define RECORDER_BATCH      8
+// 待写队列深度，队列满时丢弃新帧，采集线程不会等待文件系统
+#define RECORDER_QUEUE      32
+// 不足一批时的最长等待时间（毫秒）
+#define RECORDER_FLUSH_MS   1000
+// 录像回放发布主题，与实时画面区分
+#define TOPIC_REPLAY        "6818_replay"
+
+// ===================== 本地共享内存配置 =====================
+// 是否把每帧写入 POSIX 共享内存帧环，供本机的录像、分析、显示进程读取
+#define SHMRING_ENABLE      0      // 1=启用，0=关闭
+// 共享内存名称（/dev/shm 下）
+#define SHMRING_NAME        "/s5p6818_frames"
+// 帧环槽位数，读者落后超过该帧数时跳到最新帧
+#define SHMRING_SLOT_COUNT  4
+// 每个槽位字节数，需大于64字节槽位头+单帧图像大小
+#define SHMRING_SLOT_SIZE   (128 * 1024)
+// 本地预览程序 fb_preview 默认输出设备
+#define PREVIEW_FB_DEVICE   "/dev/fb0"
+// 预览程序连续多少秒无新帧时重新打开帧环（推流进程重启后会重建帧环）
+#define PREVIEW_REOPEN_SEC  3
+
+// ===================== 事件追踪配置 =====================
+// 是否编译追踪点，0时追踪宏为空；运行时用命令行 --trace 开始记录
+#define TRACE_ENABLE        1
+// 默认导出文件（Chrome trace JSON，可用 Perfetto / chrome://tracing 打开）
+#define TRACE_PATH          "/tmp/s5p6818_trace.json"
+// 每个线程缓冲区保存的事件数，满后覆盖最旧的事件
+#define TRACE_BUFFER_EVENTS 16384  // 每个事件24字节
+// 最多记录的线程数
+#define TRACE_MAX_THREADS   32
+
+// ===================== 按需推流配置 =====================
+// 是否按观看者启停：无观看者持有租约时暂停解码与发布，可用命令行 --on-demand 覆盖
+#define PRESENCE_ENABLE     0      // 0=始终推流（兼容不发心跳的观看端）
+// 观看者心跳主题
+#define TOPIC_VIEWER        "6818_viewer"
+// 心跳未指定 lease_ms 时的租约时长（毫秒），观看端应每 1/3 租约发送一次心跳
+#define PRESENCE_LEASE_MS   3000
+// 允许的最长租约（毫秒）
+#define PRESENCE_MAX_LEASE_MS 30000
+// 同时跟踪的观看者数
+#define PRESENCE_MAX_VIEWERS 8
+// 暂停时是否关闭摄像头：关闭更省电，但恢复需重新打开设备（数百毫秒）
+#define PRESENCE_CLOSE_CAMERA 0
+
+// ===================== 快速启动配置 =====================
+// 快速启动：舵机复位、摄像头与MQTT并行初始化，摄像头不探测流信息，可用命令行 --fast-start 覆盖
+#define FASTSTART_ENABLE    0      // 0=依次初始化舵机、摄像头、MQTT
+// 未探测时假定的MJPEG解码输出格式（UVC摄像头通常为4:2:2），首帧不符时自动按实际格式重建缩放
+#define FASTSTART_PIX_FMT   "yuvj422p"
 
-#endif
\ No newline at end of file
+#endif
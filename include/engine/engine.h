@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <config.h>
 
 // 舵机编号定义
@@ -19,6 +20,34 @@ extern double eng3_deg;
 //     int steps;    // 转动步数（基于DEG_UNIT计算）
 // };
 
+// 舵机后端接口：真实驱动或模拟器
+typedef struct {
+    const char *name;                     // 后端名称
+    int (*open)(void);                    // 打开设备，0-成功
+    int (*step)(int command, int steps);  // 驱动舵机转到目标步数，负数-失败
+    void (*close)(void);                  // 关闭设备
+} engine_backend_t;
+
+// 可选后端：hw-真实驱动 ENGINE_DEVICE，sim-模拟舵机（无需硬件）
+extern const engine_backend_t engine_backend_hw;
+extern const engine_backend_t engine_backend_sim;
+
+// 舵机到位回调，command 为舵机编号，angle 为到位角度
+typedef void (*engine_actuation_hook)(int command, double angle);
+
+// 按名称选择舵机后端，需在 engine_init 之前调用
+int engine_select_backend(const char *name);
+// 获取当前后端名称
+const char *engine_backend_name(void);
+// 设置舵机到位回调（用于延迟测量），传NULL取消
+void engine_set_actuation_hook(engine_actuation_hook hook);
+/**
+ * @brief 设置是否执行舵机指令（默认执行）
+ * 快速启动时舵机在后台复位，复位完成前置为 false：parse_json_and_control 丢弃
+ * 角度与复位指令，状态、推流配置、刷新等其他指令照常处理。可在任意线程调用。
+ */
+void engine_set_ready(bool ready);
+
 void handle_angle_control(const char *json_data);
 int engine_init();
 void print_engine_angle();
@@ -0,0 +1,40 @@
+#ifndef EPTZ_H
+#define EPTZ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <config.h>
+
+/**
+ * 电子云台：从较宽的采集画面中裁取输出窗口，用窗口移动掩盖舵机转动延迟
+ *
+ * 舵机收到新目标角度后按 EPTZ_SLEW_DEG_S 匀速转动（估算），
+ * 裁剪窗口立即偏移 (目标角度 - 估算的机械角度) * 像素/度，
+ * 随舵机到位逐渐回到画面中心，画面朝向在下一帧即可到达目标。
+ */
+
+// 云台轴
+typedef enum {
+    EPTZ_AXIS_PAN = 0,   // 水平（angle_z，Engine3）
+    EPTZ_AXIS_TILT,      // 垂直（angle_y，Engine2）
+    EPTZ_AXIS_COUNT
+} eptz_axis_t;
+
+// 启用或关闭电子云台，关闭时偏移恒为0
+void eptz_set_enabled(bool enabled);
+
+/**
+ * @brief 舵机已接受新的目标角度（下发成功后调用）
+ * @param axis 云台轴
+ * @param angle 目标角度（度）
+ */
+void eptz_command(eptz_axis_t axis, double angle);
+
+/**
+ * @brief 当前裁剪窗口相对画面中心的偏移（采集图像像素）
+ * @param dx 输出参数，水平偏移，向右为正
+ * @param dy 输出参数，垂直偏移，向下为正
+ */
+void eptz_get_offset(int *dx, int *dy);
+
+#endif
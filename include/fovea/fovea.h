@@ -0,0 +1,34 @@
+#ifndef FOVEA_H
+#define FOVEA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <config.h>
+
+/**
+ * 注视点：决定注视区域编码时全分辨率区域在输出画面中的位置
+ *
+ * 观看端通过 gaze 指令上报注视点（输出画面归一化坐标，-1~1，0为中心），
+ * 超过 FOVEA_GAZE_TIMEOUT_MS 未更新时回到画面中心。
+ */
+
+/**
+ * @brief 更新注视点（控制指令线程调用）
+ * @param x 水平位置，-1 为左边缘，1 为右边缘
+ * @param y 垂直位置，-1 为上边缘，1 为下边缘
+ */
+void fovea_set_gaze(double x, double y);
+
+/**
+ * @brief 按当前注视点计算注视区域在输出图像中的左上角
+ * 区域以注视点为中心，不超出图像，坐标取偶数
+ * @param width 输出图像宽度
+ * @param height 输出图像高度
+ * @param roi_w 注视区域宽度
+ * @param roi_h 注视区域高度
+ * @param x 输出参数，左上角横坐标
+ * @param y 输出参数，左上角纵坐标
+ */
+void fovea_roi_origin(int width, int height, int roi_w, int roi_h, int *x, int *y);
+
+#endif
@@ -4,6 +4,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <pthread.h>
 #include <config.h>
 #include <MQTTClient.h>
 
@@ -16,23 +17,193 @@ typedef struct {
     uint32_t frame_len;// payload长度
 } __attribute__((packed)) frame_header_t;
 
+// 分片模式扩展帧头魔数
+#define FRAME_CHUNK_MAGIC 0x4346 // "FC"
+
+// 扩展帧头 flags 位
+#define FRAME_FLAG_DITHERED 0x01 // 降低位深时使用了有序抖动
+#define FRAME_FLAG_FOVEATED 0x02 // 注视区域编码：帧头后紧跟 frame_roi_t，整帧作为一个分片发送
+
+/**
+ * 分片模式扩展帧头
+ * 每帧按行带切分为多条消息，每条消息 = frame_chunk_header_t + 调色板（palette_len 字节）+ 本分片图像数据。
+ * 接收端可逐行带渲染；收到新 frame_id 时若上一帧分片未收齐，直接丢弃上一帧。
+ * 非 RGB565 格式的整帧也使用本帧头（chunk_count 为1），pixel_format 取值见 pixel_format_t。
+ */
+typedef struct {
+    uint16_t magic;        // FRAME_CHUNK_MAGIC
+    uint16_t header_len;   // 本头部长度，便于后续扩展字段
+    uint32_t frame_id;     // 帧ID
+    uint32_t frame_len;    // 整帧图像数据长度
+    uint16_t chunk_index;  // 分片序号，从0开始
+    uint16_t chunk_count;  // 本帧分片总数
+    uint32_t chunk_offset; // 本分片在整帧中的字节偏移
+    uint32_t chunk_len;    // 本分片图像数据长度
+    uint16_t row_start;    // 本分片起始行
+    uint16_t row_count;    // 本分片行数
+    uint16_t width;        // 图像宽度
+    uint16_t height;       // 图像高度
+    uint8_t pixel_format;  // 像素格式（pixel_format_t）
+    uint8_t flags;         // FRAME_FLAG_*
+    uint16_t palette_len;  // 帧头后附带的调色板字节数，0表示无调色板
+} __attribute__((packed)) frame_chunk_header_t;
+
+/**
+ * 注视区域描述（flags 含 FRAME_FLAG_FOVEATED 时位于 frame_chunk_header_t 之后，计入 header_len）
+ * 图像数据 = 外围图像（periph_width*periph_height，格式为帧头 pixel_format）
+ *          + 注视区域图像（roi_width*roi_height，RGB565）。
+ * 接收端把外围图像放大到帧头的 width*height，再把注视区域覆盖到 (roi_x, roi_y)。
+ */
+typedef struct {
+    uint16_t roi_x;        // 注视区域在整幅图像中的左上角
+    uint16_t roi_y;
+    uint16_t roi_width;    // 注视区域大小（全分辨率）
+    uint16_t roi_height;
+    uint16_t periph_width; // 外围图像大小
+    uint16_t periph_height;
+} __attribute__((packed)) frame_roi_t;
+
+// 帧图像布局，随扩展帧头发送
+typedef struct {
+    uint16_t width;        // 图像宽度
+    uint16_t height;       // 图像高度
+    uint8_t pixel_format;  // 像素格式（pixel_format_t）
+    uint8_t flags;         // FRAME_FLAG_*
+    const void* palette;   // 调色板，无则为NULL
+    uint16_t palette_len;  // 调色板字节数
+    frame_roi_t roi;       // 注视区域，flags 含 FRAME_FLAG_FOVEATED 时有效
+} frame_layout_t;
+
+// MQTT 连接参数
+typedef struct {
+    const char* client_id;     // 客户端ID，同一服务器上需唯一
+    const char* sub_topic;     // 订阅主题，NULL 表示不订阅（如仅发布视频的连接）
+    int qos;                   // 订阅服务质量等级
+    int keepalive;             // 保活时间（秒）
+    const char* presence_topic;      // 观看者心跳主题，NULL 表示不订阅
+    message_handler presence_handler; // 观看者心跳处理函数
+    int mqtt5;                 // 1=优先使用 MQTT 5（服务器不支持时回退 3.1.1），0=只用 3.1.1
+    int message_expiry;        // MQTT 5 发布消息的过期时间（秒），0为不过期
+} mqtt_options_t;
+
+// MQTT 5 主题别名：首条消息携带完整主题与别名，之后只发送别名
+typedef struct {
+    char topic[64];
+    int established;           // 本次连接中服务器是否已收到该别名的映射
+} mqtt_topic_alias_t;
+
 // MQTT 上下文结构体
 typedef struct {
-    MQTTClient client;
+    MQTTClient client;            // 当前使用的客户端（client5 或 client311）
+    MQTTClient client5;           // MQTT 5 客户端，未启用时为NULL
+    MQTTClient client311;         // MQTT 3.1.1 客户端，首次需要时创建
+    char client_id[64];
+    volatile int protocol;        // 当前连接的协议版本（MQTTVERSION_3_1_1 或 MQTTVERSION_5）
+    int message_expiry;           // MQTT 5 消息过期时间（秒）
+    unsigned char v311_only[MQTT_MAX_BROKERS]; // 该服务器已拒绝 MQTT 5，之后直接用 3.1.1
+
+    // 主题别名（仅 MQTT 5），每次连接后重新建立
+    pthread_mutex_t alias_lock;   // 保证建立别名的消息先于只带别名的消息提交
+    mqtt_topic_alias_t aliases[MQTT5_TOPIC_ALIAS_MAX];
+    int alias_count;
+    int alias_max;                // 本次连接可用的别名数
+
     message_handler handler;
-    int connected;                // 连接状态标志
+    char sub_topic[64];           // 订阅主题，空串表示不订阅
+    char presence_topic[64];      // 观看者心跳主题，空串表示不订阅
+    message_handler presence_handler;
+    int sub_qos;                  // 订阅服务质量等级
+    volatile int pub_qos;         // 发布服务质量等级，默认 DEFAULT_QOS（视频连接为 VIDEO_QOS），可运行中修改
+    int keepalive;                // 保活时间（秒）
+    volatile int connected;       // 连接状态标志
     unsigned long last_reconnect; // 上次重连尝试时间（毫秒时间戳）
+    int notify_fd;                // eventfd，连接状态变化时写入，用于唤醒事件循环
+
+    // 服务器列表与故障切换
+    char brokers[MQTT_MAX_BROKERS][128]; // 按优先级排列的服务器地址
+    int broker_count;
+    int broker_index;             // 当前使用的服务器
+    int broker_attempts;          // 当前服务器连续失败次数
+
+    // 后台重连（连接在独立线程中进行，不阻塞事件循环）
+    pthread_t connect_tid;
+    int connecting;               // 连接线程是否在运行
+    volatile int connect_done;    // 连接线程已结束，等待回收
+    int connect_rc;               // 连接线程的结果
+    int attempts;                 // 本次断线以来的重连次数
+    long backoff_ms;              // 当前退避间隔
+    unsigned long next_reconnect; // 下次重连时间（毫秒时间戳）
+    unsigned long lost_at;        // 本次断线时间，0表示在线
+    unsigned int jitter_seed;     // 退避抖动随机种子
+    unsigned long reconnects;     // 累计重连成功次数
 } mqtt_ctx;
 
-// 初始化MQTT连接
+// 初始化MQTT连接（使用 BROKER_LIST 和默认客户端ID）
 int mqtt_init(mqtt_ctx* ctx, message_handler handler);
 
-// 发布消息
+/**
+ * @brief 使用指定服务器地址和客户端ID初始化MQTT连接
+ * @param address 服务器地址，多个地址用逗号分隔，按顺序尝试，断线后按顺序故障切换
+ */
+int mqtt_init_with(mqtt_ctx* ctx, message_handler handler,
+                   const char* address, const char* client_id);
+
+/**
+ * @brief 使用指定连接参数初始化MQTT连接
+ *
+ * 每个上下文是独立的 Paho 客户端（独立的套接字和收发线程），
+ * 可为控制指令单独建立连接，使其不排在大尺寸视频消息之后。
+ * options->mqtt5 为1时先以 MQTT 5 连接，服务器拒绝该协议版本时对该服务器改用 3.1.1；
+ * 服务器直接断开 MQTT 5 连接时仅本次改用 3.1.1，下次重连仍先尝试 MQTT 5；
+ * MQTT 5 连接上发布的消息带过期时间并使用主题别名，图像消息另带内容类型（MQTT5_CONTENT_TYPE_*），载荷格式不变。
+ * @param address 服务器地址，多个地址用逗号分隔
+ * @param options 连接参数
+ */
+int mqtt_init_opts(mqtt_ctx* ctx, message_handler handler,
+                   const char* address, const mqtt_options_t* options);
+
+// 发布消息（服务质量等级为 ctx->pub_qos）
 int mqtt_publish(mqtt_ctx* ctx, const char* topic, 
                 const void* payload, size_t payload_len);
 
-// 保持连接（需要在循环中调用）
-void mqtt_loop(mqtt_ctx* ctx);
+/**
+ * @brief 以指定服务质量等级发布消息
+ * QoS 0 提交后立即返回，不等待确认；QoS 1/2 最长等待 DEFAULT_TIMEOUT 毫秒
+ */
+int mqtt_publish_qos(mqtt_ctx* ctx, const char* topic,
+                     const void* payload, size_t payload_len, int qos);
+
+/**
+ * @brief 以指定服务质量等级发布消息，MQTT 5 连接上附带内容类型
+ * @param content_type 内容类型（如 MQTT5_CONTENT_TYPE_FRAME），NULL 表示不带；3.1.1 连接上忽略
+ */
+int mqtt_publish_typed(mqtt_ctx* ctx, const char* topic,
+                       const void* payload, size_t payload_len, int qos,
+                       const char* content_type);
+
+/**
+ * @brief 按行带分片发布一帧图像
+ * @param frame_id 帧ID
+ * @param data 整帧图像数据（按行连续存放，不含调色板）
+ * @param data_len 整帧数据长度
+ * @param layout 图像尺寸、像素格式与调色板，调色板随每个分片发送
+ * @param chunk_bytes 每个分片的目标字节数，向下取整到整行；注视区域编码的帧不分片
+ * @param qos 服务质量等级，0 时不等待分片确认
+ * @return int 0-成功，非0-失败
+ */
+int mqtt_publish_chunked(mqtt_ctx* ctx, const char* topic, uint32_t frame_id,
+                         const void* data, size_t data_len,
+                         const frame_layout_t* layout, size_t chunk_bytes, int qos);
+
+/**
+ * @brief 维护连接：断线时按指数退避（带随机抖动）在后台线程中重连
+ *
+ * 收发由 Paho 后台线程完成，无需周期调用；在 notify_fd 可读或上次返回的时间到期时调用即可。
+ * 本函数不阻塞：连接在独立线程中进行，完成后通过 notify_fd 通知。断线后首次重试立即进行，
+ * 同一服务器连续失败 MAX_RECONNECT_ATTEMPTS 次后切换到列表中的下一台服务器。
+ * @return long 距离下次需要调用的毫秒数，-1 表示已连接或正在等待连接结果、无需定时调用
+ */
+long mqtt_loop(mqtt_ctx* ctx);
 
 // 断开连接
 void mqtt_disconnect(mqtt_ctx* ctx);
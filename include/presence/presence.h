@@ -0,0 +1,57 @@
+#ifndef PRESENCE_H
+#define PRESENCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <config.h>
+
+/**
+ * 观看者租约：观看端定期向 TOPIC_VIEWER 发送心跳，每次心跳续租 lease_ms 毫秒
+ *
+ * 心跳格式: {"viewer": "glasses-01", "lease_ms": 3000}
+ * 离开时:   {"viewer": "glasses-01", "leave": true}
+ * 没有未过期的租约时采集线程暂停解码与发布，第一个租约到来时立即唤醒。
+ */
+
+// 观看者统计
+typedef struct {
+    int viewers;                 // 当前持有租约的观看者数
+    uint64_t suspends;           // 暂停次数
+    uint64_t resumes;            // 恢复次数
+    uint64_t last_resume_us;     // 最近一次恢复耗时（心跳到达 -> 首帧入队）
+    uint64_t max_resume_us;      // 最大恢复耗时
+    uint64_t idle_us;            // 累计暂停时长
+} presence_stats_t;
+
+// 初始化，enabled 为 false 时 presence_active 恒为 true
+void presence_init(bool enabled);
+
+// 是否按观看者启停
+bool presence_enabled(void);
+
+// 处理 TOPIC_VIEWER 上的心跳消息（MQTT 接收线程调用）
+void presence_handle(const char *payload);
+
+// 当前是否有观看者
+bool presence_active(void);
+
+/**
+ * @brief 等待观看者出现（采集线程调用）
+ * @param timeout_ms 最长等待时间
+ * @return bool true-有观看者
+ */
+bool presence_wait(int timeout_ms);
+
+// 采集线程进入暂停
+void presence_mark_suspended(void);
+
+// 暂停后的第一帧已入队，记录恢复耗时
+void presence_mark_resumed(void);
+
+// 获取统计
+void presence_get_stats(presence_stats_t *stats);
+
+// 打印观看者与暂停统计
+void presence_print_status(void);
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <config.h>
+
+// 单个事件循环最多注册的文件描述符数量
+#define REACTOR_MAX_HANDLERS 16
+
+// 文件描述符就绪回调
+typedef void (*reactor_callback)(int fd, uint32_t events, void *arg);
+
+// 已注册的文件描述符
+typedef struct {
+    int fd;
+    reactor_callback cb;
+    void *arg;
+} reactor_handler_t;
+
+// 事件循环上下文：epoll + eventfd 跨线程唤醒
+typedef struct {
+    int epoll_fd;                                    // epoll 实例
+    int wakeup_fd;                                   // eventfd，用于跨线程/信号处理函数唤醒
+    volatile int running;                            // 运行标志
+    reactor_handler_t handlers[REACTOR_MAX_HANDLERS];
+    int handler_count;
+    uint64_t wakeups;                                // epoll_wait 返回次数（用于统计空转）
+} reactor_ctx;
+
+// 周期定时器：基于 timerfd 的绝对截止时间，不随循环体耗时漂移
+typedef struct {
+    int fd;               // timerfd
+    long period_us;       // 周期（微秒）
+    uint64_t ticks;       // 已经过的周期数
+    uint64_t missed;      // 因处理超时而错过的周期数
+} reactor_ticker_t;
+
+// 初始化事件循环
+int reactor_init(reactor_ctx *ctx);
+
+// 注册文件描述符，events 为 EPOLLIN 等
+int reactor_add(reactor_ctx *ctx, int fd, uint32_t events, reactor_callback cb, void *arg);
+
+// 注销文件描述符
+void reactor_remove(reactor_ctx *ctx, int fd);
+
+// 运行事件循环，直到 reactor_stop 被调用
+int reactor_run(reactor_ctx *ctx);
+
+// 停止事件循环（可在信号处理函数中调用）
+void reactor_stop(reactor_ctx *ctx);
+
+// 唤醒事件循环（可在任意线程或信号处理函数中调用）
+void reactor_wakeup(reactor_ctx *ctx);
+
+// 释放事件循环资源
+void reactor_destroy(reactor_ctx *ctx);
+
+// 创建单次定时器（CLOCK_MONOTONIC timerfd，非阻塞）
+int reactor_timer_create(void);
+
+// 设置单次定时器在 delay_ms 毫秒后到期，delay_ms < 0 表示取消
+int reactor_timer_arm_ms(int timer_fd, long delay_ms);
+
+// 读取并清除 timerfd/eventfd 的计数，返回到期次数
+uint64_t reactor_drain(int fd);
+
+// 初始化周期定时器，首个截止时间为当前时刻 + 一个周期
+int reactor_ticker_init(reactor_ticker_t *ticker, long period_us);
+
+// 修改周期定时器的周期，从当前时刻重新对齐
+int reactor_ticker_set_period(reactor_ticker_t *ticker, long period_us);
+
+/**
+ * @brief 阻塞等待下一个截止时间
+ * @return uint64_t 本次经过的周期数，大于1表示有周期被错过
+ */
+uint64_t reactor_ticker_wait(reactor_ticker_t *ticker);
+
+// 关闭周期定时器
+void reactor_ticker_close(reactor_ticker_t *ticker);
+
+#endif
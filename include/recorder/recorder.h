@@ -0,0 +1,127 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <config.h>
+#include "mqtt/mqtt.h"
+
+// 环形录像文件头部魔数与版本
+#define RECORDER_FILE_MAGIC 0x52363831  // "R681"
+#define RECORDER_SLOT_MAGIC 0x534C4F54  // "SLOT"
+// 文件格式版本，与当前版本不同的文件在打开时重新创建：
+//   1: 槽位只存 frame_header_t + 图像数据，回放时一律按默认 RGB565 帧头发布，
+//      非 RGB565、非默认尺寸与注视区域编码的帧回放后无法解码
+//   2: 帧头后附带 recorder_layout_t，回放与实时推流使用相同的帧头格式
+//   3: 槽位记录头带 CRC32，断电时写了一半的槽位在重建索引时被丢弃
+#define RECORDER_VERSION    3
+#define RECORDER_FILE_HEADER_SIZE 4096  // 文件头占用一个页，槽位区按页对齐
+
+// 环形文件头（位于文件起始处）
+typedef struct {
+    uint32_t magic;       // RECORDER_FILE_MAGIC
+    uint32_t version;     // RECORDER_VERSION
+    uint32_t slot_count;  // 槽位数量
+    uint32_t slot_size;   // 每个槽位字节数
+} __attribute__((packed)) recorder_file_header_t;
+
+// 槽位记录头（位于每个槽位起始处，后接 frame_header_t + recorder_layout_t + 图像数据）
+typedef struct {
+    uint32_t magic;        // RECORDER_SLOT_MAGIC
+    uint32_t payload_len;  // frame_header_t + recorder_layout_t + 图像数据的总长度
+    uint64_t seq;          // 单调递增写入序号，用于重启后恢复写入位置
+    uint64_t timestamp_ms; // 采集时刻（CLOCK_REALTIME 毫秒）
+    uint32_t crc;          // CRC32：覆盖本结构中 crc 之前的字段与 payload_len 字节的记录内容
+} __attribute__((packed)) recorder_slot_header_t;
+
+// 录像帧的图像布局（frame_layout_t 去掉调色板指针；调色板位于图像数据开头）
+// 回放时据此按与实时推流相同的帧头格式发布，非 RGB565、非默认尺寸与注视区域编码的帧都能正确解码
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint8_t pixel_format;  // 像素格式（pixel_format_t）
+    uint8_t flags;         // FRAME_FLAG_*
+    uint16_t palette_len;  // 图像数据开头的调色板字节数
+    frame_roi_t roi;       // 注视区域，flags 含 FRAME_FLAG_FOVEATED 时有效
+} __attribute__((packed)) recorder_layout_t;
+
+/**
+ * 回放发布回调：按实时推流的帧头格式发布一帧（与直播共用同一发布路径）
+ * @param header 帧头（frame_len 含调色板）
+ * @param layout 图像布局，palette 为NULL，调色板位于 data 开头
+ * @return int 0-成功，非0-失败
+ */
+typedef int (*recorder_publish_fn)(const frame_header_t *header, const frame_layout_t *layout,
+                                   const unsigned char *data, long size);
+
+// 查找方式
+typedef enum {
+    RECORDER_SEEK_FRAME_ID = 0, // 按帧ID查找（本次运行录下的第一个 >= key 的帧，帧ID每次启动从0开始）
+    RECORDER_SEEK_TIME,         // 按时间查找（第一个时间戳 >= key 毫秒的帧）
+} recorder_seek_t;
+
+// 录像配置
+typedef struct {
+    const char *path;     // 环形文件路径
+    uint32_t slot_count;  // 槽位数量
+    uint32_t slot_size;   // 每槽位最大字节数（含槽位记录头）
+    int batch;            // 每批写入的帧数
+    int queue_depth;      // 待写队列深度，队列满时丢帧而不阻塞采集线程
+    int flush_ms;         // 不足一批时最长等待时间
+    recorder_publish_fn replay_publish; // 回放时发布一帧，NULL则不支持回放
+} recorder_config_t;
+
+// 录像统计信息
+typedef struct {
+    uint64_t appended;    // 已进入写队列的帧数
+    uint64_t written;     // 已写入文件的帧数
+    uint64_t dropped;     // 因队列满或帧过大而丢弃的帧数
+    uint64_t batches;     // 批量写入次数
+    uint32_t valid_slots; // 当前可回放的帧数
+} recorder_stats_t;
+
+// 打开（必要时创建并预分配）环形文件，启动后台写线程
+int recorder_init(const recorder_config_t *config);
+
+/**
+ * @brief 追加一帧到写队列，不会等待文件系统
+ * @param header 帧头
+ * @param layout 图像布局（palette 指针忽略，调色板应位于 data 开头）
+ * @param data 图像数据
+ * @return int 0-成功入队，-1-未初始化，-2-队列已满或帧过大（已丢弃）
+ */
+int recorder_append(const frame_header_t *header, const frame_layout_t *layout, const void *data);
+
+/**
+ * @brief 在索引中查找帧
+ * @return int 槽位编号，未找到返回-1
+ */
+int recorder_find(recorder_seek_t mode, uint64_t key);
+
+/**
+ * @brief 读取槽位中的帧（frame_header_t + recorder_layout_t + 图像数据）
+ * @param slot 槽位编号
+ * @param buffer 输出参数，函数内部分配内存，调用者负责释放
+ * @param size 输出参数，返回buffer的大小
+ * @param timestamp_ms 输出参数，可为NULL，返回采集时间戳
+ * @return int 0-成功，负数-失败
+ */
+int recorder_read(int slot, unsigned char **buffer, long *size, uint64_t *timestamp_ms);
+
+/**
+ * @brief 启动后台回放，将录像帧交给 replay_publish 按实时推流的格式发布
+ * @param mode 查找方式
+ * @param key 帧ID或毫秒时间戳
+ * @param count 回放帧数，0表示回放到最新帧，不能为负数
+ * @return int 0-成功，负数-失败（参数无效、未找到或已有回放在进行）
+ */
+int recorder_replay_start(recorder_seek_t mode, uint64_t key, int count);
+
+// 获取统计信息
+void recorder_get_stats(recorder_stats_t *stats);
+
+// 刷新剩余数据，停止写线程并关闭文件
+void recorder_close(void);
+
+#endif
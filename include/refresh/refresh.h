@@ -0,0 +1,51 @@
+#ifndef REFRESH_H
+#define REFRESH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <config.h>
+
+/**
+ * 丢帧统计与刷新请求：视频以 VIDEO_QOS（默认0）发布，不等待确认，过时的帧不重传
+ *
+ * 接收端按 frame_id 检测缺口，在指令主题上发送刷新请求并附带缺失范围：
+ *   {"cmd_type": "refresh", "from": 1200, "to": 1203}
+ * 设备记录最近 REFRESH_HISTORY 个已发布的帧ID，据此把缺失的帧区分为
+ * 网络丢失（已发布但接收端未收到）和设备主动丢帧（发送队列丢弃、从未发布）。
+ * 刷新请求使下一帧以 REFRESH_QOS 发送，保证接收端得到一幅完整画面。
+ */
+
+// 丢帧统计
+typedef struct {
+    uint64_t published;          // 已发布帧数
+    uint64_t requests;           // 收到的刷新请求数
+    uint64_t refreshes;          // 以 REFRESH_QOS 发送的刷新帧数
+    uint64_t net_lost;           // 接收端报告缺失且确已发布的帧数（网络丢失）
+    uint64_t local_dropped;      // 接收端报告缺失但设备未发布的帧数（发送队列丢弃）
+    uint64_t unknown;            // 超出发布记录范围、无法区分的缺失帧数
+} refresh_stats_t;
+
+// 一帧已成功发布（发布线程调用）
+void refresh_note_published(uint32_t frame_id);
+
+/**
+ * @brief 处理刷新请求（指令线程调用）
+ * @param has_range 是否附带缺失范围
+ * @param first 第一个缺失的帧ID
+ * @param last 最后一个缺失的帧ID
+ */
+void refresh_request(bool has_range, uint32_t first, uint32_t last);
+
+/**
+ * @brief 取出待处理的刷新请求（发布线程每帧调用）
+ * @return bool true-本帧应以 REFRESH_QOS 发送
+ */
+bool refresh_take(void);
+
+// 获取统计
+void refresh_get_stats(refresh_stats_t *stats);
+
+// 打印丢帧统计
+void refresh_print_status(void);
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef SENDQ_H
+#define SENDQ_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <config.h>
+#include "mqtt/mqtt.h"
+
+// 丢帧原因
+typedef enum {
+    SENDQ_DROP_OVERFLOW = 0, // 队列已满，被更新的帧挤出
+    SENDQ_DROP_EXPIRED,      // 出队时已超过截止时间
+    SENDQ_DROP_LATE,         // 按估计发送耗时将错过截止时间
+    SENDQ_DROP_SEND_FAILED,  // 发送失败
+    SENDQ_DROP_OFFLINE,      // MQTT断线期间未发送
+    SENDQ_DROP_REASON_COUNT
+} sendq_drop_reason_t;
+
+// 队列中的一帧
+typedef struct {
+    frame_header_t header;   // 帧头
+    frame_layout_t layout;   // 图像尺寸与像素格式（palette 指针不使用，调色板位于 data 开头）
+    unsigned char *data;     // 图像数据，出队后由调用者释放
+    long size;               // 图像数据长度
+    uint64_t capture_us;     // 采集时刻（CLOCK_MONOTONIC 微秒）
+    uint64_t deadline_us;    // 截止时刻（CLOCK_MONOTONIC 微秒）
+} sendq_item_t;
+
+// 发送队列统计信息
+typedef struct {
+    uint64_t pushed;                               // 入队帧数
+    uint64_t sent;                                 // 成功发送帧数
+    uint64_t sent_late;                            // 超过截止时间但仍发送的帧数（无更新帧可替代）
+    uint64_t dropped[SENDQ_DROP_REASON_COUNT];     // 各原因丢帧数
+    uint64_t est_send_us;                          // 当前发送耗时估计（微秒）
+    uint64_t last_latency_us;                      // 最近一帧从采集到发送完成的耗时
+} sendq_stats_t;
+
+/**
+ * @brief 初始化发送队列
+ * @param depth 队列深度，满时丢弃最旧的帧
+ * @param deadline_ms 每帧从采集起允许的最大发送延迟（毫秒）
+ * @return int 0-成功，负数-失败
+ */
+int sendq_init(int depth, long deadline_ms);
+
+/**
+ * @brief 帧入队，队列接管 data 的所有权
+ * @param layout 本帧的尺寸与像素格式，随帧保存，运行中修改视频参数时不会错配
+ * @return int 0-成功，-1-队列已关闭（data 已释放）
+ */
+int sendq_push(const frame_header_t *header, const frame_layout_t *layout,
+               unsigned char *data, long size, uint64_t capture_us);
+
+/**
+ * @brief 取出下一帧可发送的帧，没有帧时阻塞等待
+ *
+ * 若队首帧已过期或预计赶不上截止时间，且其后还有更新的帧，则丢弃队首帧。
+ * 队列中最新的一帧总会被发送，避免链路持续偏慢时画面完全停止。
+ * @return int 0-成功取出，-1-队列已关闭
+ */
+int sendq_pop(sendq_item_t *item);
+
+/**
+ * @brief 报告一帧的发送结果，用于更新发送耗时估计和统计
+ * @param item 已出队的帧
+ * @param send_us 本次发送耗时（微秒）
+ * @param ok 是否发送成功
+ */
+void sendq_report(const sendq_item_t *item, uint64_t send_us, bool ok);
+
+// 记录一帧出队后未发送而丢弃（如断线期间），不影响发送耗时估计
+void sendq_report_drop(sendq_drop_reason_t reason);
+
+// 获取统计信息
+void sendq_get_stats(sendq_stats_t *stats);
+
+// 打印统计信息
+void sendq_print_stats(void);
+
+// 获取丢帧原因名称
+const char *sendq_drop_reason_name(sendq_drop_reason_t reason);
+
+// 关闭队列，唤醒阻塞在 sendq_pop 的线程
+void sendq_shutdown(void);
+
+// 释放队列中剩余的帧
+void sendq_destroy(void);
+
+// 获取 CLOCK_MONOTONIC 微秒时间戳
+uint64_t sendq_now_us(void);
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * 共享内存帧环（POSIX shm），供同一板上的本地进程读取画面
+ *
+ * 单写多读：采集线程写入，读者只读映射，不加锁、不通知写端。
+ * 每个槽位带序号锁（seqlock）：写入前后各加一，奇数表示正在写入；
+ * 读者在读取前后比较序号锁，不一致说明读取期间被覆盖，丢弃即可。
+ * 读者可直接使用映射中的数据（零拷贝），用完后调用 shmring_frame_valid 确认未被覆盖。
+ * 本头文件不依赖其它模块，读者进程只需链接 shmring 库。
+ */
+
+#define SHMRING_MAGIC       0x53524E47  // "SRNG"
+#define SHMRING_VERSION     2
+#define SHMRING_HEADER_SIZE 4096        // 环头占一个页，槽位区按页对齐
+#define SHMRING_SLOT_META   64          // 槽位记录头大小，图像数据从此偏移开始
+
+// 环头（位于共享内存起始处）
+typedef struct {
+    uint32_t magic;        // SHMRING_MAGIC
+    uint32_t version;      // SHMRING_VERSION
+    uint32_t slot_count;   // 槽位数量
+    uint32_t slot_size;    // 每个槽位字节数（含槽位记录头）
+    uint64_t head_seq;     // 最新一帧的序号，0表示尚无数据
+    uint32_t notify;       // 每写完一帧加一，读者可在此等待（futex）
+    uint32_t writer_pid;   // 写端进程ID
+} shmring_header_t;
+
+// 槽位记录头，后接 data_len 字节数据（PAL8 时前 palette_len 字节为调色板）
+// 注视区域编码时数据 = 外围图像 + 注视区域图像，布局与MQTT的 frame_roi_t 相同
+typedef struct {
+    uint32_t lock;         // 序号锁：奇数表示正在写入
+    uint32_t data_len;     // 数据字节数
+    uint64_t seq;          // 帧序号，槽位号 = (seq - 1) % slot_count
+    uint64_t capture_us;   // 采集时刻（CLOCK_MONOTONIC 微秒）
+    uint32_t frame_id;     // 帧ID，与MQTT帧头一致
+    uint16_t width;        // 图像宽度
+    uint16_t height;       // 图像高度
+    uint8_t pixel_format;  // 像素格式（pixel_format_t）
+    uint8_t flags;         // FRAME_FLAG_* 标志
+    uint16_t palette_len;  // 数据开头的调色板字节数
+    uint16_t roi_x, roi_y; // 注视区域左上角（roi_width 为0表示普通整帧）
+    uint16_t roi_width, roi_height;       // 注视区域大小，RGB565，位于外围图像之后
+    uint16_t periph_width, periph_height; // 注视区域编码时的外围图像大小
+} shmring_slot_t;
+
+// 写端
+typedef struct {
+    char name[64];
+    int fd;
+    uint8_t *base;
+    size_t map_size;
+    shmring_header_t *header;
+    uint64_t seq;          // 已写入的帧数
+    uint64_t oversized;    // 因超过槽位大小而未写入的帧数
+} shmring_writer_t;
+
+// 读端
+typedef struct {
+    int fd;
+    const uint8_t *base;
+    size_t map_size;
+    const shmring_header_t *header;
+    uint64_t last_seq;     // 上次读到的帧序号
+    uint64_t missed;       // 读者来不及读取而跳过的帧数
+    uint64_t torn;         // 读取期间被覆盖而丢弃的帧数
+} shmring_reader_t;
+
+// 读者看到的一帧（data 指向共享内存，零拷贝）
+typedef struct {
+    uint64_t seq;
+    uint32_t lock;         // 读取时的序号锁，用于事后校验
+    uint32_t frame_id;
+    uint64_t capture_us;
+    uint16_t width, height;
+    uint8_t pixel_format, flags;
+    uint16_t palette_len;
+    uint16_t roi_x, roi_y, roi_width, roi_height;  // 注视区域，roi_width 为0表示普通整帧
+    uint16_t periph_width, periph_height;          // 外围图像大小
+    const uint8_t *data;
+    uint32_t data_len;
+} shmring_frame_t;
+
+// ---------------- 写端 ----------------
+
+/**
+ * @brief 创建（或重建）共享内存帧环
+ * @param name shm 名称，如 "/s5p6818_frames"
+ * @param slot_count 槽位数量
+ * @param slot_size 每个槽位字节数（含 SHMRING_SLOT_META）
+ * @return int 0-成功，负数-失败
+ */
+int shmring_create(shmring_writer_t *ring, const char *name, uint32_t slot_count, uint32_t slot_size);
+
+/**
+ * @brief 写入一帧，不会阻塞；最旧的槽位被覆盖
+ * @param meta 帧信息（seq/lock/data 字段忽略）
+ * @return int 0-成功，-1-未创建，-2-帧超过槽位大小
+ */
+int shmring_write(shmring_writer_t *ring, const shmring_frame_t *meta, const void *data, size_t len);
+
+// 删除共享内存并解除映射
+void shmring_destroy(shmring_writer_t *ring);
+
+// ---------------- 读端 ----------------
+
+// 以只读方式打开帧环，从下一帧开始读取
+int shmring_open(shmring_reader_t *reader, const char *name);
+
+/**
+ * @brief 等待新帧
+ * @param timeout_ms 超时毫秒数，负数为一直等待
+ * @return int 1-有新帧，0-超时
+ */
+int shmring_wait(shmring_reader_t *reader, int timeout_ms);
+
+/**
+ * @brief 取最新一帧（零拷贝），比上次读到的更旧的帧直接跳过
+ * @return int 0-成功，-1-暂无新帧，-2-读取期间被覆盖（可重试）
+ */
+int shmring_read_latest(shmring_reader_t *reader, shmring_frame_t *frame);
+
+// 使用完 frame->data 后确认其未被写端覆盖
+bool shmring_frame_valid(const shmring_reader_t *reader, const shmring_frame_t *frame);
+
+// 关闭读端
+void shmring_close(shmring_reader_t *reader);
+
+#endif
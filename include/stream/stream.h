@@ -0,0 +1,56 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <config.h>
+
+// 视频流运行参数（可通过 stream_config 命令在运行中修改）
+typedef struct {
+    int width;           // 输出宽度
+    int height;          // 输出高度
+    int capture_width;   // 采集宽度
+    int capture_height;  // 采集高度
+    int crop_width;      // 电子云台裁剪窗口宽度，0为不裁剪
+    int crop_height;     // 电子云台裁剪窗口高度
+    int roi_width;       // 注视区域宽度，0为不启用注视区域编码
+    int roi_height;      // 注视区域高度
+    int fps;             // 目标帧率
+    int qos;             // 视频发布服务质量等级
+    int pixel_format;    // 输出像素格式（pixel_format_t）
+    bool dither;         // 降低位深时是否抖动
+} stream_config_t;
+
+// 设置当前生效的参数（启动时及每次重新配置成功后调用）
+void stream_set_current(const stream_config_t *config);
+
+// 获取当前生效的参数
+void stream_get_current(stream_config_t *config);
+
+/**
+ * @brief 提交新的参数，由采集线程在下一帧之前应用
+ *
+ * 只做校验和登记，立即返回，不阻塞调用线程；连续提交时以最后一次为准。
+ * @return int 0-已登记，-1-参数无效
+ */
+int stream_request(const stream_config_t *config);
+
+/**
+ * @brief 取出待应用的参数（采集线程每帧调用）
+ * @return bool true-有新参数
+ */
+bool stream_take_pending(stream_config_t *config);
+
+/**
+ * @brief 记录一次重新配置的结果
+ * @param config 请求的参数
+ * @param elapsed_us 重新配置耗时（微秒）
+ * @param result 0-成功，-1-失败（原参数仍生效），-2-失败且摄像头已关闭
+ */
+void stream_report(const stream_config_t *config, uint64_t elapsed_us, int result);
+
+// 打印当前参数与最近一次重新配置的结果
+void stream_print_status(void);
+
+#endif
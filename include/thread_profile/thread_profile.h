@@ -0,0 +1,55 @@
+#ifndef THREAD_PROFILE_H
+#define THREAD_PROFILE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <config.h>
+
+// 线程角色
+typedef enum {
+    THREAD_ROLE_CONTROL = 0, // 舵机指令处理（MQTT消息回调线程）
+    THREAD_ROLE_LISTEN,      // MQTT连接维护事件循环
+    THREAD_ROLE_CAPTURE,     // 摄像头采集与解码
+    THREAD_ROLE_PUBLISH,     // 视频发布
+    THREAD_ROLE_COUNT
+} thread_role_t;
+
+// 线程放置配置
+typedef struct {
+    const char *name;        // 线程名（不超过15字节）
+    int policy;              // 调度策略：SCHED_FIFO / SCHED_RR / SCHED_OTHER
+    int priority;            // 实时策略下为优先级(1-99)，SCHED_OTHER 下为 nice 值
+    unsigned long cpu_mask;  // CPU亲和性位掩码，0表示不限制
+} thread_profile_t;
+
+// 线程配置生效情况（读回内核实际设置）
+typedef struct {
+    bool applied;            // 是否已调用过 thread_profile_apply
+    bool fallback;           // 是否因权限不足等原因降级
+    int policy;              // 实际调度策略
+    int priority;            // 实际优先级（SCHED_OTHER 下为 nice 值）
+    unsigned long cpu_mask;  // 实际CPU亲和性
+} thread_profile_status_t;
+
+/**
+ * @brief 初始化线程放置配置
+ * @param lock_memory 是否调用 mlockall 锁定内存，避免缺页造成实时线程抖动
+ * @return int 0-成功，负数-部分设置失败（已降级，不影响运行）
+ */
+int thread_profile_init(bool lock_memory);
+
+/**
+ * @brief 将角色对应的调度策略、优先级和CPU亲和性应用到调用线程
+ *
+ * 权限不足时降级为普通调度，并读回内核实际设置用于核对。
+ * @return int 0-完全生效，1-已降级，负数-失败
+ */
+int thread_profile_apply(thread_role_t role);
+
+// 获取角色的配置生效情况
+void thread_profile_get_status(thread_role_t role, thread_profile_status_t *status);
+
+// 打印所有角色的配置与实际生效情况
+void thread_profile_print(void);
+
+#endif
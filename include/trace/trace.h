@@ -0,0 +1,51 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <config.h>
+
+/**
+ * 事件追踪：记录各线程的开始/结束事件，导出为 Chrome trace JSON（可用 Perfetto 打开）
+ *
+ * 每个线程首次记录时分配自己的环形缓冲区，记录时不加锁；缓冲区满后覆盖最旧的事件。
+ * TRACE_ENABLE 为0时追踪点编译为空；为1但未调用 trace_init 时只多一次分支判断。
+ * 事件名必须是字符串常量（只保存指针）。
+ */
+
+// 追踪是否正在记录（由 trace_init/trace_shutdown 设置）
+extern volatile int trace_active;
+
+#define TRACE_BEGIN(name) do { if (TRACE_ENABLE && trace_active) trace_record((name), 'B'); } while (0)
+#define TRACE_END(name)   do { if (TRACE_ENABLE && trace_active) trace_record((name), 'E'); } while (0)
+#define TRACE_INSTANT(name) do { if (TRACE_ENABLE && trace_active) trace_record((name), 'i'); } while (0)
+
+/**
+ * @brief 开始记录
+ * @param path 导出文件路径
+ * @return int 0-成功，负数-失败
+ */
+int trace_init(const char *path);
+
+// 记录一个事件（phase: 'B' 开始，'E' 结束，'i' 瞬时），请使用上面的宏
+void trace_record(const char *name, char phase);
+
+/**
+ * @brief 请求导出，可在信号处理函数中调用（只写 eventfd）
+ * 导出在注册了 trace_notify_fd 的事件循环线程中进行
+ */
+void trace_request_dump(void);
+
+// 导出请求通知的 eventfd，未初始化时返回 -1
+int trace_notify_fd(void);
+
+// 处理导出请求（事件循环回调中调用），读出 eventfd 计数后导出
+void trace_handle_notify(void);
+
+// 把所有线程当前缓冲区中的事件写入导出文件，返回写入的事件数，失败返回负数
+int trace_dump(void);
+
+// 停止记录，导出一次并释放缓冲区（须在其它线程退出后调用）
+void trace_shutdown(void);
+
+#endif
@@ -0,0 +1,865 @@
+#include "bench/bench.h"
+#include "engine/engine.h"
+#include "mqtt/mqtt.h"
+#include "camera/scaler.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cjson/cJSON.h>
+#include <libavutil/imgutils.h>
+
+// 单条回放指令
+typedef struct {
+    char *json;            // 附加 bench_seq 后的指令JSON
+    uint64_t offset_us;    // 相对首条指令的发送时刻
+    uint64_t publish_us;   // 实际发布时刻
+    uint64_t arrival_us;   // 设备端收到时刻
+    uint64_t done_us;      // 舵机写入完成时刻（到位回调），0为未驱动舵机
+    bool handled;          // 设备端已处理
+} bench_command_t;
+
+static bench_command_t *bench_cmds = NULL;
+static int bench_count = 0;
+static int bench_done = 0;
+static pthread_mutex_t bench_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bench_cond = PTHREAD_COND_INITIALIZER;
+static volatile int bench_load_stop = 0;
+static __thread uint64_t actuated_us = 0; // 本线程最近一次舵机写入完成时刻
+
+// 获取 CLOCK_MONOTONIC 微秒时间戳
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// 计算一组延迟样本的统计值
+void bench_latency_compute(uint64_t *samples, int count, bench_latency_t *result) {
+    uint64_t sum = 0;
+
+    memset(result, 0, sizeof(*result));
+    if (!samples || count <= 0) {
+        return;
+    }
+    qsort(samples, count, sizeof(uint64_t), compare_u64);
+    for (int i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    result->count = count;
+    result->min_us = samples[0];
+    result->max_us = samples[count - 1];
+    result->avg_us = sum / count;
+    result->p50_us = samples[(count - 1) * 50 / 100];
+    result->p90_us = samples[(count - 1) * 90 / 100];
+    result->p99_us = samples[(count - 1) * 99 / 100];
+}
+
+// 打印延迟统计结果
+void bench_latency_print(const char *label, const bench_latency_t *result) {
+    printf("%-12s n=%-5d min=%7.2f avg=%7.2f p50=%7.2f p90=%7.2f p99=%7.2f max=%7.2f (ms)\n",
+           label, result->count,
+           result->min_us / 1000.0, result->avg_us / 1000.0,
+           result->p50_us / 1000.0, result->p90_us / 1000.0,
+           result->p99_us / 1000.0, result->max_us / 1000.0);
+}
+
+// 舵机到位回调：后端下发目标步数成功后在处理指令的线程中调用
+static void bench_actuation_hook(int command, double angle) {
+    (void)command;
+    (void)angle;
+    actuated_us = now_us();
+}
+
+// 设备端指令处理：记录到达时刻，照常解析执行，到位时刻取最后一次舵机写入
+static void bench_handler(const char *payload) {
+    uint64_t arrival = now_us();
+    int seq = -1;
+
+    cJSON *root = cJSON_Parse(payload);
+    if (root) {
+        cJSON *seq_obj = cJSON_GetObjectItem(root, "bench_seq");
+        if (seq_obj && cJSON_IsNumber(seq_obj)) {
+            seq = seq_obj->valueint;
+        }
+        cJSON_Delete(root);
+    }
+
+    actuated_us = 0;
+    parse_json_and_control(payload);
+
+    if (seq < 0 || seq >= bench_count) {
+        return;
+    }
+    pthread_mutex_lock(&bench_lock);
+    bench_cmds[seq].arrival_us = arrival;
+    bench_cmds[seq].done_us = actuated_us;
+    bench_cmds[seq].handled = true;
+    bench_done++;
+    pthread_cond_signal(&bench_cond);
+    pthread_mutex_unlock(&bench_lock);
+}
+
+// 读取指令记录文件，为每条指令附加 bench_seq 用于匹配
+static int load_commands(const char *path) {
+    FILE *file = fopen(path, "r");
+    char line[1024];
+    double first_ms = -1;
+    int line_no = 0;
+
+    if (!file) {
+        perror("无法打开指令记录文件");
+        return -1;
+    }
+    bench_cmds = (bench_command_t *)calloc(BENCH_MAX_COMMANDS, sizeof(bench_command_t));
+    if (!bench_cmds) {
+        fprintf(stderr, "内存分配失败\n");
+        fclose(file);
+        return -1;
+    }
+
+    bench_count = 0;
+    while (fgets(line, sizeof(line), file) && bench_count < BENCH_MAX_COMMANDS) {
+        char *p = line;
+        char *end = NULL;
+        double ts_ms;
+
+        line_no++;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0' || *p == '#') {
+            continue;
+        }
+
+        // 可选的行首时间戳，缺省时按固定间隔发送
+        if (*p != '{') {
+            ts_ms = strtod(p, &end);
+            if (end == p) {
+                fprintf(stderr, "第 %d 行格式错误，已跳过\n", line_no);
+                continue;
+            }
+            p = end;
+            while (isspace((unsigned char)*p)) p++;
+        } else {
+            ts_ms = (first_ms < 0) ? 0 : first_ms +
+                    (double)bench_count * BENCH_INTERVAL_MS;
+        }
+
+        cJSON *root = cJSON_Parse(p);
+        if (!root) {
+            fprintf(stderr, "第 %d 行JSON解析失败，已跳过\n", line_no);
+            continue;
+        }
+        cJSON_AddNumberToObject(root, "bench_seq", bench_count);
+        bench_cmds[bench_count].json = cJSON_PrintUnformatted(root);
+        cJSON_Delete(root);
+        if (!bench_cmds[bench_count].json) {
+            continue;
+        }
+
+        if (first_ms < 0) {
+            first_ms = ts_ms;
+        }
+        bench_cmds[bench_count].offset_us = (uint64_t)((ts_ms - first_ms) * 1000.0);
+        bench_count++;
+    }
+    fclose(file);
+
+    if (bench_count == 0) {
+        fprintf(stderr, "指令记录文件中没有有效指令\n");
+        return -1;
+    }
+    return 0;
+}
+
+// 释放指令缓存
+static void free_commands(void) {
+    if (bench_cmds) {
+        for (int i = 0; i < bench_count; i++) {
+            free(bench_cmds[i].json);
+        }
+        free(bench_cmds);
+        bench_cmds = NULL;
+    }
+    bench_count = 0;
+    bench_done = 0;
+}
+
+// 汇总并打印延迟统计
+static void report_latency(const char *mode) {
+    uint64_t *total = (uint64_t *)malloc(sizeof(uint64_t) * bench_count);
+    uint64_t *network = (uint64_t *)malloc(sizeof(uint64_t) * bench_count);
+    uint64_t *actuation = (uint64_t *)malloc(sizeof(uint64_t) * bench_count);
+    bench_latency_t result;
+    int n = 0;
+    int idle = 0;
+
+    if (!total || !network || !actuation) {
+        fprintf(stderr, "内存分配失败\n");
+        free(total);
+        free(network);
+        free(actuation);
+        return;
+    }
+
+    for (int i = 0; i < bench_count; i++) {
+        const bench_command_t *cmd = &bench_cmds[i];
+        if (!cmd->handled || cmd->publish_us == 0) {
+            continue;
+        }
+        // 角度未变化或超出范围时不写舵机，没有到位时刻
+        if (cmd->done_us == 0) {
+            idle++;
+            continue;
+        }
+        total[n] = cmd->done_us - cmd->publish_us;
+        network[n] = cmd->arrival_us - cmd->publish_us;
+        actuation[n] = cmd->done_us - cmd->arrival_us;
+        n++;
+    }
+
+    printf("========== 舵机控制延迟 (后端: %s, %s) ==========\n", engine_backend_name(), mode);
+    printf("已发布 %d 条，已驱动舵机 %d 条，未驱动舵机 %d 条\n", bench_count, n, idle);
+    bench_latency_compute(network, n, &result);
+    bench_latency_print("发布->到达", &result);
+    bench_latency_compute(actuation, n, &result);
+    bench_latency_print("到达->到位", &result);
+    bench_latency_compute(total, n, &result);
+    bench_latency_print("发布->到位", &result);
+
+    free(total);
+    free(network);
+    free(actuation);
+}
+
+// 视频负载线程：在视频连接上连续发布整帧大小的消息，使上行带宽饱和
+static void *video_load_thread(void *arg) {
+    mqtt_ctx *video_ctx = (mqtt_ctx *)arg;
+    size_t size = sizeof(frame_header_t) + 240 * 240 * 2;
+    unsigned char *payload = (unsigned char *)calloc(1, size);
+    unsigned long frames = 0;
+
+    if (!payload) {
+        fprintf(stderr, "内存分配失败\n");
+        return NULL;
+    }
+    while (!bench_load_stop) {
+        if (mqtt_publish(video_ctx, TOPIC_PUB, payload, size) == 0) {
+            frames++;
+        } else {
+            usleep(10000);
+        }
+    }
+    printf("视频负载: 共发布 %lu 帧\n", frames);
+    free(payload);
+    return NULL;
+}
+
+// 按记录的时间间隔回放一轮指令：split 为真时控制指令走独立连接
+static int run_pass(MQTTClient publisher, const char *broker, bool split, bool video_load) {
+    mqtt_options_t video_opts = {
+        .client_id = BENCH_DEVICE_CLIENT_ID,
+        .sub_topic = split ? NULL : TOPIC_SUB,
+        .qos = DEFAULT_QOS,
+        .keepalive = MQTT_KEEPALIVE,
+    };
+    mqtt_options_t control_opts = {
+        .client_id = BENCH_CONTROL_CLIENT_ID,
+        .sub_topic = TOPIC_SUB,
+        .qos = CONTROL_QOS,
+        .keepalive = CONTROL_KEEPALIVE,
+    };
+    mqtt_ctx video_ctx, control_ctx;
+    pthread_t load_tid;
+    bool load_started = false;
+    int rc;
+
+    // 清空上一轮的时间戳
+    pthread_mutex_lock(&bench_lock);
+    for (int i = 0; i < bench_count; i++) {
+        bench_cmds[i].publish_us = 0;
+        bench_cmds[i].arrival_us = 0;
+        bench_cmds[i].done_us = 0;
+        bench_cmds[i].handled = false;
+    }
+    bench_done = 0;
+    pthread_mutex_unlock(&bench_lock);
+
+    // 设备端：与正常运行相同的连接方式、订阅与解析路径
+    if (mqtt_init_opts(&video_ctx, bench_handler, broker, &video_opts) != 0) {
+        fprintf(stderr, "设备端MQTT初始化失败\n");
+        return -1;
+    }
+    if (split && mqtt_init_opts(&control_ctx, bench_handler, broker, &control_opts) != 0) {
+        fprintf(stderr, "设备端控制连接初始化失败\n");
+        mqtt_disconnect(&video_ctx);
+        return -1;
+    }
+    if (video_load) {
+        bench_load_stop = 0;
+        load_started = pthread_create(&load_tid, NULL, video_load_thread, &video_ctx) == 0;
+    }
+
+    uint64_t start = now_us();
+    for (int i = 0; i < bench_count; i++) {
+        MQTTClient_message pubmsg = MQTTClient_message_initializer;
+        MQTTClient_deliveryToken token;
+        uint64_t due = start + bench_cmds[i].offset_us;
+        uint64_t now = now_us();
+
+        if (due > now) {
+            usleep((useconds_t)(due - now));
+        }
+
+        pubmsg.payload = bench_cmds[i].json;
+        pubmsg.payloadlen = (int)strlen(bench_cmds[i].json);
+        pubmsg.qos = split ? CONTROL_QOS : DEFAULT_QOS;
+        pubmsg.retained = 0;
+
+        pthread_mutex_lock(&bench_lock);
+        bench_cmds[i].publish_us = now_us();
+        pthread_mutex_unlock(&bench_lock);
+        if ((rc = MQTTClient_publishMessage(publisher, TOPIC_SUB, &pubmsg, &token)) != MQTTCLIENT_SUCCESS) {
+            fprintf(stderr, "指令 %d 发布失败: %d\n", i, rc);
+            bench_cmds[i].publish_us = 0;
+            continue;
+        }
+        MQTTClient_waitForCompletion(publisher, token, DEFAULT_TIMEOUT);
+    }
+
+    // 等待设备端处理完剩余指令，最多等待5秒
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 5;
+    pthread_mutex_lock(&bench_lock);
+    while (bench_done < bench_count) {
+        if (pthread_cond_timedwait(&bench_cond, &bench_lock, &deadline) != 0) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&bench_lock);
+
+    if (load_started) {
+        bench_load_stop = 1;
+        pthread_join(load_tid, NULL);
+    }
+    if (split) {
+        mqtt_disconnect(&control_ctx);
+    }
+    mqtt_disconnect(&video_ctx);
+
+    report_latency(split ? "独立控制连接" : "与视频共用连接");
+    return 0;
+}
+
+// 舵机控制闭环延迟基准测试
+int bench_engine_run(const char *path, const char *broker, bool video_load) {
+    MQTTClient publisher = NULL;
+    MQTTClient_connectOptions conn_opts = MQTTClient_connectOptions_initializer;
+    int rc, ret = 0;
+
+    if (load_commands(path) != 0) {
+        free_commands();
+        return -1;
+    }
+    printf("已加载 %d 条指令，服务器: %s，视频负载: %s\n",
+           bench_count, broker, video_load ? "开" : "关");
+
+    if (engine_init() != 0) {
+        fprintf(stderr, "舵机初始化失败\n");
+        free_commands();
+        return -1;
+    }
+
+    // 发送端：模拟穿戴设备发布指令
+    if ((rc = MQTTClient_create(&publisher, broker, BENCH_CLIENT_ID,
+                                MQTTCLIENT_PERSISTENCE_NONE, NULL)) != MQTTCLIENT_SUCCESS) {
+        fprintf(stderr, "创建发送端失败: %d\n", rc);
+        engine_close();
+        free_commands();
+        return -1;
+    }
+    conn_opts.keepAliveInterval = 20;
+    conn_opts.cleansession = 1;
+    conn_opts.connectTimeout = MQTT_CONNECT_TIMEOUT;
+    if ((rc = MQTTClient_connect(publisher, &conn_opts)) != MQTTCLIENT_SUCCESS) {
+        fprintf(stderr, "发送端连接失败: %d\n", rc);
+        MQTTClient_destroy(&publisher);
+        engine_close();
+        free_commands();
+        return -1;
+    }
+
+    // 两种连接方式各回放一轮，便于直接对比
+    engine_set_actuation_hook(bench_actuation_hook);
+    if (run_pass(publisher, broker, false, video_load) != 0 ||
+        run_pass(publisher, broker, true, video_load) != 0) {
+        ret = -1;
+    }
+
+    MQTTClient_disconnect(publisher, DEFAULT_TIMEOUT);
+    MQTTClient_destroy(&publisher);
+    engine_set_actuation_hook(NULL);
+    engine_close();
+    free_commands();
+    return ret;
+}
+
+// 切片并行缩放基准测试
+int bench_scale_run(int max_workers, int iterations) {
+    const int src_w = 640, src_h = 480, dst_w = 240, dst_h = 240;
+    const enum AVPixelFormat src_fmt = AV_PIX_FMT_YUVJ422P;
+    const enum AVPixelFormat dst_fmt = AV_PIX_FMT_RGB565;
+    uint8_t *src[4], *ref[4], *dst[4];
+    int src_stride[4], ref_stride[4], dst_stride[4];
+    double base_ms = 0;
+    int ret = 0;
+
+    if (max_workers < 1 || max_workers > SCALER_MAX_WORKERS || iterations < 1) {
+        fprintf(stderr, "基准测试参数无效\n");
+        return -1;
+    }
+    if (av_image_alloc(src, src_stride, src_w, src_h, src_fmt, 16) < 0 ||
+        av_image_alloc(ref, ref_stride, dst_w, dst_h, dst_fmt, 16) < 0 ||
+        av_image_alloc(dst, dst_stride, dst_w, dst_h, dst_fmt, 16) < 0) {
+        fprintf(stderr, "内存分配失败\n");
+        return -1;
+    }
+
+    // 合成测试图像：亮度为斜向渐变加细纹理，色度为水平/垂直渐变
+    for (int y = 0; y < src_h; y++) {
+        for (int x = 0; x < src_w; x++) {
+            src[0][y * src_stride[0] + x] = (uint8_t)((x + y) / 5 + ((x ^ y) & 7) * 4);
+        }
+        for (int x = 0; x < src_w / 2; x++) {
+            src[1][y * src_stride[1] + x] = (uint8_t)(x * 255 / (src_w / 2));
+            src[2][y * src_stride[2] + x] = (uint8_t)(y * 255 / src_h);
+        }
+    }
+
+    printf("========== 缩放基准测试: %dx%d %s -> %dx%d RGB565, %d 次迭代 ==========\n",
+           src_w, src_h, "YUVJ422P", dst_w, dst_h, iterations);
+    for (int workers = 1; workers <= max_workers; workers++) {
+        scaler_ctx ctx;
+        uint8_t *const *out = (workers == 1) ? ref : dst;
+        const int *out_stride = (workers == 1) ? ref_stride : dst_stride;
+
+        if (scaler_init(&ctx, src_w, src_h, src_fmt, dst_w, dst_h, dst_fmt, workers) != 0) {
+            ret = -1;
+            break;
+        }
+
+        // 预热一次，不计入耗时
+        scaler_run(&ctx, (const uint8_t *const *)src, src_stride, out, out_stride);
+        uint64_t start = now_us();
+        for (int i = 0; i < iterations; i++) {
+            scaler_run(&ctx, (const uint8_t *const *)src, src_stride, out, out_stride);
+        }
+        double ms = (now_us() - start) / 1000.0 / iterations;
+        if (workers == 1) {
+            base_ms = ms;
+        }
+
+        // 与单线程输出逐行比较
+        int diff_rows = 0;
+        if (workers > 1) {
+            int row_bytes = av_image_get_linesize(dst_fmt, dst_w, 0);
+            for (int y = 0; y < dst_h; y++) {
+                if (memcmp(ref[0] + y * ref_stride[0], dst[0] + y * dst_stride[0], row_bytes) != 0) {
+                    diff_rows++;
+                }
+            }
+        }
+
+        printf("线程数 %d (实际切片 %d): %7.3f ms/帧, 加速比 %.2fx, 与单线程不同的行数: %d\n",
+               workers, ctx.slice_count, ms, base_ms / ms, diff_rows);
+        scaler_destroy(&ctx);
+    }
+
+    av_freep(&src[0]);
+    av_freep(&ref[0]);
+    av_freep(&dst[0]);
+    return ret;
+}
+
+// 只支持 3.1.1 的模拟服务器，用于测试 MQTT 5 回退
+typedef struct {
+    int listen_fd;
+    int port;
+    bool drop;             // true=收到 MQTT 5 CONNECT 直接断开，false=以 CONNACK 返回码1拒绝
+    int v5_attempts;       // 收到的 MQTT 5 CONNECT 次数
+    int v311_connects;     // 接受的 3.1.1 连接次数
+    int publishes;         // 3.1.1 连接上收到的 PUBLISH 数
+} fake_broker_t;
+
+static int mqtt5_failures = 0;
+
+// 记录一项检查结果
+static void mqtt5_check(const char *name, bool ok) {
+    printf("  [%s] %s\n", ok ? "通过" : "失败", name);
+    if (!ok) {
+        mqtt5_failures++;
+    }
+}
+
+// 读满 len 字节，连接关闭或出错返回 -1
+static int read_full(int fd, void *buf, size_t len) {
+    unsigned char *p = (unsigned char *)buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0) {
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// 读取一个 MQTT 控制报文，可变头与载荷超出 cap 的部分丢弃；返回报文类型字节，-1 为连接关闭
+static int read_packet(int fd, unsigned char *body, size_t cap, size_t *body_len) {
+    unsigned char type, byte;
+    size_t remaining = 0;
+    int shift = 0;
+
+    if (read_full(fd, &type, 1) != 0) {
+        return -1;
+    }
+    do {
+        if (shift > 21 || read_full(fd, &byte, 1) != 0) {
+            return -1;
+        }
+        remaining |= (size_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    *body_len = remaining < cap ? remaining : cap;
+    if (read_full(fd, body, *body_len) != 0) {
+        return -1;
+    }
+    for (size_t left = remaining - *body_len; left > 0; ) {
+        unsigned char discard[256];
+        size_t n = left < sizeof(discard) ? left : sizeof(discard);
+        if (read_full(fd, discard, n) != 0) {
+            return -1;
+        }
+        left -= n;
+    }
+    return type;
+}
+
+// 服务一个客户端连接：CONNECT 的协议级别为5时拒绝或断开，为4时接受并应答心跳直至断开
+static void fake_broker_serve(fake_broker_t *fb, int fd) {
+    static const unsigned char connack_ok[] = { 0x20, 0x02, 0x00, 0x00 };
+    static const unsigned char connack_reject[] = { 0x20, 0x02, 0x00, 0x01 }; // 不接受的协议版本
+    static const unsigned char pingresp[] = { 0xD0, 0x00 };
+    unsigned char body[512];
+    size_t len;
+    ssize_t ret;
+
+    // CONNECT 可变头：协议名 "MQTT"（2字节长度+4字节）之后为协议级别
+    if (read_packet(fd, body, sizeof(body), &len) != 0x10 || len < 7) {
+        return;
+    }
+    if (body[6] != 4) {
+        fb->v5_attempts++;
+        if (!fb->drop) {
+            ret = write(fd, connack_reject, sizeof(connack_reject));
+            (void)ret;
+        }
+        return;
+    }
+    fb->v311_connects++;
+    if (write(fd, connack_ok, sizeof(connack_ok)) != (ssize_t)sizeof(connack_ok)) {
+        return;
+    }
+    for (;;) {
+        int type = read_packet(fd, body, sizeof(body), &len);
+        if (type < 0 || (type & 0xF0) == 0xE0) {         // 断开或 DISCONNECT
+            return;
+        }
+        if ((type & 0xF0) == 0x30) {                     // PUBLISH（测试中只发 QoS 0）
+            fb->publishes++;
+        } else if ((type & 0xF0) == 0xC0) {              // PINGREQ
+            ret = write(fd, pingresp, sizeof(pingresp));
+            (void)ret;
+        }
+    }
+}
+
+// 模拟服务器线程：逐个接受连接，监听套接字被 shutdown 后退出
+static void *fake_broker_thread(void *arg) {
+    fake_broker_t *fb = (fake_broker_t *)arg;
+    for (;;) {
+        int fd = accept(fb->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            break;
+        }
+        fake_broker_serve(fb, fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+// 在本机随机端口上启动模拟服务器
+static int fake_broker_start(fake_broker_t *fb, bool drop, pthread_t *tid) {
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+
+    memset(fb, 0, sizeof(*fb));
+    fb->drop = drop;
+    fb->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fb->listen_fd < 0) {
+        perror("创建模拟服务器套接字失败");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (bind(fb->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(fb->listen_fd, 4) != 0 ||
+        getsockname(fb->listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        perror("启动模拟服务器失败");
+        close(fb->listen_fd);
+        return -1;
+    }
+    fb->port = ntohs(addr.sin_port);
+    if (pthread_create(tid, NULL, fake_broker_thread, fb) != 0) {
+        fprintf(stderr, "创建模拟服务器线程失败\n");
+        close(fb->listen_fd);
+        return -1;
+    }
+    return 0;
+}
+
+// 停止模拟服务器：shutdown 使阻塞的 accept 返回，当前连接服务完才退出
+static void fake_broker_stop(fake_broker_t *fb, pthread_t tid) {
+    shutdown(fb->listen_fd, SHUT_RDWR);
+    pthread_join(tid, NULL);
+    close(fb->listen_fd);
+}
+
+// 测试一种回退路径：设备端以 MQTT 5 优先连接只支持 3.1.1 的服务器
+static void run_fallback(bool drop) {
+    mqtt_options_t opts = {
+        .client_id = BENCH_DEVICE_CLIENT_ID,
+        .sub_topic = NULL,
+        .qos = DEFAULT_QOS,
+        .keepalive = MQTT_KEEPALIVE,
+        .mqtt5 = 1,
+        .message_expiry = BENCH_MQTT5_EXPIRY,
+    };
+    static const char payload[] = "{}";
+    fake_broker_t fb;
+    pthread_t tid;
+    mqtt_ctx ctx;
+    char address[64];
+    bool connected;
+
+    printf("回退测试（服务器%s）:\n", drop ? "断开MQTT 5连接" : "以返回码1拒绝MQTT 5");
+    if (fake_broker_start(&fb, drop, &tid) != 0) {
+        mqtt5_check("启动模拟服务器", false);
+        return;
+    }
+    snprintf(address, sizeof(address), "tcp://127.0.0.1:%d", fb.port);
+
+    connected = mqtt_init_opts(&ctx, NULL, address, &opts) == 0;
+    if (connected) {
+        mqtt5_check("以 3.1.1 建立连接", ctx.protocol == MQTTVERSION_3_1_1);
+        // 只有明确拒绝才记住；断开可能是网络原因，下次重连仍尝试 MQTT 5
+        mqtt5_check(drop ? "断开不记住为只支持 3.1.1" : "拒绝后记住该服务器只支持 3.1.1",
+                    (ctx.v311_only[0] != 0) == !drop);
+        mqtt5_check("3.1.1 连接上发布",
+                    mqtt_publish_typed(&ctx, BENCH_MQTT5_TOPIC, payload, sizeof(payload) - 1, 0,
+                                       MQTT5_CONTENT_TYPE_FRAME) == 0);
+        mqtt_disconnect(&ctx);
+    } else {
+        mqtt5_check("以 3.1.1 建立连接", false);
+    }
+    fake_broker_stop(&fb, tid);
+
+    mqtt5_check("先尝试 MQTT 5", fb.v5_attempts == 1);
+    if (connected) {
+        mqtt5_check("服务器收到 3.1.1 消息", fb.v311_connects == 1 && fb.publishes == 1);
+    }
+}
+
+// 取字符串属性并与 expect 比较，expect 为 NULL 时检查属性不存在
+static bool property_string_is(MQTTProperties *props, int code, const char *expect) {
+    MQTTProperty *prop = MQTTProperties_getProperty(props, code);
+    if (!expect) {
+        return prop == NULL;
+    }
+    return prop && prop->value.data.len == (int)strlen(expect) &&
+           memcmp(prop->value.data.data, expect, prop->value.data.len) == 0;
+}
+
+// 连接真实服务器，检查主题别名、消息过期时间和内容类型
+static void run_broker_checks(const char *broker) {
+    mqtt_options_t opts = {
+        .client_id = BENCH_DEVICE_CLIENT_ID,
+        .sub_topic = NULL,
+        .qos = DEFAULT_QOS,
+        .keepalive = MQTT_KEEPALIVE,
+        .mqtt5 = 1,
+        .message_expiry = BENCH_MQTT5_EXPIRY,
+    };
+    MQTTClient_createOptions create_opts = MQTTClient_createOptions_initializer;
+    MQTTClient_connectOptions conn_opts = MQTTClient_connectOptions_initializer5;
+    char *topics[2] = { BENCH_MQTT5_TOPIC, BENCH_MQTT5_PLAIN_TOPIC };
+    int qos[2] = { 1, 1 };
+    static const char plain[] = "{\"bench\":1}";
+    unsigned char frame[sizeof(frame_header_t) + 64];
+    MQTTClient observer = NULL;
+    MQTTResponse response;
+    mqtt_ctx ctx;
+    int frames = 0, plains = 0, frame_ok = 0, plain_ok = 0, stray = 0;
+    int rc;
+
+    printf("服务器测试（%s）:\n", broker);
+
+    // 观察端：以 MQTT 5 订阅，收到的消息带服务器转发的属性
+    create_opts.MQTTVersion = MQTTVERSION_5;
+    if ((rc = MQTTClient_createWithOptions(&observer, broker, BENCH_CLIENT_ID,
+                                           MQTTCLIENT_PERSISTENCE_NONE, NULL, &create_opts)) != MQTTCLIENT_SUCCESS) {
+        fprintf(stderr, "创建观察端失败: %d\n", rc);
+        mqtt5_check("观察端连接", false);
+        return;
+    }
+    conn_opts.keepAliveInterval = 20;
+    conn_opts.cleanstart = 1;
+    conn_opts.connectTimeout = MQTT_CONNECT_TIMEOUT;
+    response = MQTTClient_connect5(observer, &conn_opts, NULL, NULL);
+    rc = response.reasonCode;
+    MQTTResponse_free(response);
+    if (rc != MQTTCLIENT_SUCCESS) {
+        fprintf(stderr, "观察端连接失败: %d\n", rc);
+        mqtt5_check("观察端连接", false);
+        MQTTClient_destroy(&observer);
+        return;
+    }
+    response = MQTTClient_subscribeMany5(observer, 2, topics, qos, NULL, NULL);
+    rc = response.reasonCode;
+    MQTTResponse_free(response);
+    if (rc < 0 || rc >= 0x80) {
+        fprintf(stderr, "观察端订阅失败: %d\n", rc);
+        mqtt5_check("观察端订阅", false);
+        MQTTClient_disconnect(observer, DEFAULT_TIMEOUT);
+        MQTTClient_destroy(&observer);
+        return;
+    }
+
+    // 设备端：与正常运行相同的发布路径
+    if (mqtt_init_opts(&ctx, NULL, broker, &opts) != 0) {
+        mqtt5_check("设备端连接", false);
+        MQTTClient_disconnect(observer, DEFAULT_TIMEOUT);
+        MQTTClient_destroy(&observer);
+        return;
+    }
+    mqtt5_check("以 MQTT 5 建立连接", ctx.protocol == MQTTVERSION_5);
+    mqtt5_check("服务器允许主题别名", ctx.alias_max > 0);
+
+    memset(frame, 0, sizeof(frame));
+    for (int i = 0; i < BENCH_MQTT5_FRAMES; i++) {
+        ((frame_header_t *)frame)->frame_id = (uint32_t)i;
+        if (mqtt_publish_typed(&ctx, BENCH_MQTT5_TOPIC, frame, sizeof(frame), 1,
+                               MQTT5_CONTENT_TYPE_FRAME) != 0) {
+            fprintf(stderr, "图像消息 %d 发布失败\n", i);
+        }
+    }
+    mqtt5_check("图像主题已建立别名",
+                ctx.alias_count > 0 && strcmp(ctx.aliases[0].topic, BENCH_MQTT5_TOPIC) == 0 &&
+                ctx.aliases[0].established);
+    if (mqtt_publish_qos(&ctx, BENCH_MQTT5_PLAIN_TOPIC, plain, sizeof(plain) - 1, 1) != 0) {
+        fprintf(stderr, "普通消息发布失败\n");
+    }
+
+    // 只带别名的消息由服务器还原主题后转发，观察端应收到完整主题
+    while (frames + plains < BENCH_MQTT5_FRAMES + 1) {
+        char *topic = NULL;
+        int topic_len = 0;
+        MQTTClient_message *msg = NULL;
+
+        rc = MQTTClient_receive(observer, &topic, &topic_len, &msg, 2000);
+        if (!msg) {
+            break;
+        }
+        if (topic && strcmp(topic, BENCH_MQTT5_TOPIC) == 0) {
+            int expiry = MQTTProperties_hasProperty(&msg->properties,
+                                                    MQTTPROPERTY_CODE_MESSAGE_EXPIRY_INTERVAL)
+                ? MQTTProperties_getNumericValue(&msg->properties,
+                                                 MQTTPROPERTY_CODE_MESSAGE_EXPIRY_INTERVAL)
+                : 0;
+            frames++;
+            if (expiry > 0 && expiry <= BENCH_MQTT5_EXPIRY &&
+                property_string_is(&msg->properties, MQTTPROPERTY_CODE_CONTENT_TYPE,
+                                   MQTT5_CONTENT_TYPE_FRAME)) {
+                frame_ok++;
+            }
+        } else if (topic && strcmp(topic, BENCH_MQTT5_PLAIN_TOPIC) == 0) {
+            plains++;
+            if (property_string_is(&msg->properties, MQTTPROPERTY_CODE_CONTENT_TYPE, NULL)) {
+                plain_ok++;
+            }
+        } else {
+            stray++;
+        }
+        MQTTClient_freeMessage(&msg);
+        if (topic) {
+            MQTTClient_free(topic);
+        }
+    }
+    printf("  观察端收到图像消息 %d/%d 条，普通消息 %d/1 条，主题不符 %d 条\n",
+           frames, BENCH_MQTT5_FRAMES, plains, stray);
+    mqtt5_check("只带别名的图像消息按原主题送达", frames == BENCH_MQTT5_FRAMES && stray == 0);
+    mqtt5_check("图像消息带过期时间与内容类型 " MQTT5_CONTENT_TYPE_FRAME,
+                frames > 0 && frame_ok == frames);
+    mqtt5_check("普通消息不带内容类型", plains == 1 && plain_ok == 1);
+
+    mqtt_disconnect(&ctx);
+    MQTTClient_disconnect(observer, DEFAULT_TIMEOUT);
+    MQTTClient_destroy(&observer);
+}
+
+// MQTT 5 功能测试
+int bench_mqtt5_run(const char *broker) {
+    mqtt5_failures = 0;
+    run_fallback(false);
+    run_fallback(true);
+    run_broker_checks(broker);
+    printf("MQTT 5 测试%s，%d 项未通过\n", mqtt5_failures ? "失败" : "通过", mqtt5_failures);
+    return mqtt5_failures ? -1 : 0;
+}
+
+// 延迟发送 SIGINT 的线程
+static void *shutdown_thread(void *arg) {
+    int delay_ms = (int)(intptr_t)arg;
+    usleep((useconds_t)delay_ms * 1000);
+    printf("[bench] 启动 %d 毫秒，发送SIGINT\n", delay_ms);
+    kill(getpid(), SIGINT);
+    return NULL;
+}
+
+// 启动期间终止信号回归检查
+int bench_shutdown_arm(int delay_ms) {
+    pthread_t tid;
+
+    if (delay_ms < 0 || pthread_create(&tid, NULL, shutdown_thread, (void *)(intptr_t)delay_ms) != 0) {
+        fprintf(stderr, "创建信号线程失败\n");
+        return -1;
+    }
+    pthread_detach(tid);
+    return 0;
+}
@@ -1,6 +1,13 @@
 #include "camera/camera_test.h"
+#include "camera/scaler.h"
+#include "camera/pixfmt.h"
 #include "config/config.h"
+#include "thread_profile/thread_profile.h"
+#include "trace/trace.h"
+#include "eptz/eptz.h"
+#include "fovea/fovea.h"
 #include <string.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
@@ -12,42 +19,135 @@
 #include <libavdevice/avdevice.h>
 #include <libswscale/swscale.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/time.h>
+#include <libavutil/pixdesc.h>
 
 #define IMAGE_FILE "image.rgb"  // 临时测试文件，存储图像数据的文件路径
-#define RGB565_PIXEL_SIZE 2     // 16位RGB565格式每像素占2字节
-#define TARGET_WIDTH 240        // 目标图像宽度
-#define TARGET_HEIGHT 240       // 目标图像高度
-#define TARGET_SIZE (TARGET_WIDTH * TARGET_HEIGHT * RGB565_PIXEL_SIZE) // 目标图像大小
 
 // FFmpeg相关全局变量
 static AVFormatContext *format_ctx = NULL;
 static AVCodecContext *codec_ctx = NULL;
 static AVFrame *frame = NULL;
 static AVFrame *rgb_frame = NULL;
-static struct SwsContext *sws_ctx = NULL;
+static scaler_ctx scaler;           // 切片并行缩放上下文
+static bool scaler_ready = false;
+static pixfmt_ctx converter;        // 缩放输出 -> 目标像素格式
+static long frame_size = 0;         // 目标格式一帧的字节数
+static int crop_w = 0, crop_h = 0;  // 缩放输入窗口大小（不裁剪时为整幅画面）
+static int out_w = 0, out_h = 0;    // 输出图像大小（注视区域编码时为整幅画面，缩放输出为外围图像）
+static enum AVPixelFormat src_fmt = AV_PIX_FMT_NONE; // 缩放输入（解码输出）的像素格式
+static int src_w = 0, src_h = 0;    // 缩放输入（解码输出）的画面大小
+
+// 注视区域编码：主缩放上下文输出缩小的外围图像，roi_scaler 从采集画面直接输出全分辨率注视区域
+static bool roi_enabled = false;
+static scaler_ctx roi_scaler;
+static int roi_w = 0, roi_h = 0;          // 注视区域大小（输出像素）
+static int roi_src_w = 0, roi_src_h = 0;  // 注视区域对应的采集画面窗口大小
+static int periph_w = 0, periph_h = 0;    // 外围图像大小
+static long periph_size = 0;              // 外围图像（含调色板）字节数
+static camera_roi_t last_roi;             // 最近一帧的注视区域
 static AVPacket packet;
 static uint8_t *rgb_buffer = NULL;
 static int video_stream_index = -1;
 static uint32_t frame_counter = 0;
 static bool camera_ready = false;
+static camera_config_t current_config; // 当前生效的配置
+static camera_stats_t stats;           // 采集统计
 
-// 初始化摄像头，设置参数并打开设备
-int camera_init(camera_config_t *config) {
-    int ret;
-    AVCodec *codec = NULL;
-    AVDictionary *options = NULL;
-    char device_format[64];
+// 最新帧抓取：读取线程持续取包，只保留最新一个未解码的数据包
+static bool grab_latest = false;
+static pthread_t drain_tid;
+static bool drain_started = false;
+static volatile int drain_stop = 0;
+static pthread_mutex_t latest_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t latest_cond = PTHREAD_COND_INITIALIZER;
+static AVPacket latest_packet;
+static bool latest_valid = false;
+static int drain_error = 0;             // 读取线程退出时的错误码
+static bool capture_lost = false;       // 读取出错或输出阶段重建失败后采集阶段已关闭，取帧时重新打开
+
+// 阻塞读取的中断回调：关闭设备时让 av_read_frame 立即返回
+static int drain_interrupt(void *opaque) {
+    (void)opaque;
+    return drain_stop;
+}
+
+// 读取线程：尽快取出驱动与解复用器中的数据包，新包直接替换尚未解码的旧包
+static void *drain_thread(void *arg) {
+    AVPacket pkt;
+    (void)arg;
     
-    // 参数检查
-    if (!config || !config->device) {
-        fprintf(stderr, "摄像头配置无效\n");
-        return -1;
+    if (THREAD_PROFILE_ENABLE) {
+        thread_profile_apply(THREAD_ROLE_CAPTURE);
     }
     
-    // 如果已经初始化，先释放资源
-    if (camera_ready) {
-        camera_deinit();
+    while (!drain_stop) {
+        TRACE_BEGIN("av_read_frame");
+        int ret = av_read_frame(format_ctx, &pkt);
+        TRACE_END("av_read_frame");
+        if (ret == AVERROR(EAGAIN)) {
+            // 非阻塞设备暂无数据：短暂让出CPU，避免空转
+            usleep(DRAIN_RETRY_US);
+            continue;
+        }
+        if (ret < 0) {
+            pthread_mutex_lock(&latest_lock);
+            drain_error = ret;
+            pthread_cond_broadcast(&latest_cond);
+            pthread_mutex_unlock(&latest_lock);
+            break;
+        }
+        if (pkt.stream_index != video_stream_index) {
+            av_packet_unref(&pkt);
+            continue;
+        }
+        
+        pthread_mutex_lock(&latest_lock);
+        if (latest_valid) {
+            av_packet_unref(&latest_packet);
+            stats.skipped++;
+        }
+        av_packet_move_ref(&latest_packet, &pkt);
+        latest_valid = true;
+        pthread_cond_signal(&latest_cond);
+        pthread_mutex_unlock(&latest_lock);
+    }
+    return NULL;
+}
+
+// 停止读取线程并丢弃未解码的数据包
+static void stop_drain(void) {
+    if (drain_started) {
+        drain_stop = 1;
+        pthread_join(drain_tid, NULL);
+        drain_started = false;
+    }
+    if (latest_valid) {
+        av_packet_unref(&latest_packet);
+        latest_valid = false;
+    }
+    drain_stop = 0;
+    drain_error = 0;
+}
+
+// 快速启动：不探测流信息，按请求的采集参数补全解复用器未给出的编解码参数
+static void apply_known_params(AVCodecParameters *par, const camera_config_t *config) {
+    if (par->codec_id == AV_CODEC_ID_NONE) {
+        par->codec_id = AV_CODEC_ID_MJPEG;
+    }
+    if (par->width <= 0 || par->height <= 0) {
+        par->width = config->capture_width;
+        par->height = config->capture_height;
     }
+}
+
+// 打开采集设备与解码器（采集阶段）
+static int open_capture(const camera_config_t *config) {
+    int ret;
+    AVCodec *codec = NULL;
+    AVDictionary *options = NULL;
+    char video_size[32];
+    char framerate[16];
     
     // 注册所有设备和编解码器
     avdevice_register_all();
@@ -58,36 +158,46 @@ int camera_init(camera_config_t *config) {
         fprintf(stderr, "无法分配AVFormatContext\n");
         return -1;
     }
+    format_ctx->interrupt_callback.callback = drain_interrupt;
+    format_ctx->interrupt_callback.opaque = NULL;
     
     // 设置设备选项
-    snprintf(device_format, sizeof(device_format), "video=%s", config->device);
-    av_dict_set(&options, "framerate", "30", 0); // 设置采集帧率
-    av_dict_set(&options, "video_size", "640x480", 0); // 设置采集分辨率
+    snprintf(video_size, sizeof(video_size), "%dx%d", config->capture_width, config->capture_height);
+    snprintf(framerate, sizeof(framerate), "%d", config->capture_fps);
+    av_dict_set(&options, "framerate", framerate, 0); // 设置采集帧率
+    av_dict_set(&options, "video_size", video_size, 0); // 设置采集分辨率
     av_dict_set(&options, "input_format", "mjpeg", 0); // 优先使用MJPEG格式
+    av_dict_set(&options, "timestamps", "mono2abs", 0); // 时间戳转为绝对时间，用于计算帧龄
     
     // 打开视频设备
     AVInputFormat *input_format = av_find_input_format("v4l2"); // Linux下使用V4L2
     if (!input_format) {
         fprintf(stderr, "找不到v4l2输入格式\n");
+        av_dict_free(&options);
         avformat_free_context(format_ctx);
+        format_ctx = NULL;
         return -1;
     }
     
     ret = avformat_open_input(&format_ctx, config->device, input_format, &options);
+    av_dict_free(&options);
     if (ret < 0) {
         char err_buf[128];
         av_strerror(ret, err_buf, sizeof(err_buf));
         fprintf(stderr, "无法打开摄像头设备: %s\n", err_buf);
         avformat_free_context(format_ctx);
+        format_ctx = NULL;
         return -1;
     }
     
-    // 获取流信息
-    ret = avformat_find_stream_info(format_ctx, NULL);
-    if (ret < 0) {
-        fprintf(stderr, "无法获取流信息\n");
-        avformat_close_input(&format_ctx);
-        return -1;
+    // 获取流信息：探测要读取并解码若干帧，快速启动时跳过，直接使用已知的采集参数
+    if (!config->fast_start) {
+        ret = avformat_find_stream_info(format_ctx, NULL);
+        if (ret < 0) {
+            fprintf(stderr, "无法获取流信息\n");
+            avformat_close_input(&format_ctx);
+            return -1;
+        }
     }
     
     // 查找视频流
@@ -104,6 +214,9 @@ int camera_init(camera_config_t *config) {
         avformat_close_input(&format_ctx);
         return -1;
     }
+    if (config->fast_start) {
+        apply_known_params(format_ctx->streams[video_stream_index]->codecpar, config);
+    }
     
     // 获取解码器
     codec = avcodec_find_decoder(format_ctx->streams[video_stream_index]->codecpar->codec_id);
@@ -130,6 +243,19 @@ int camera_init(camera_config_t *config) {
         return -1;
     }
     
+    // 最新帧抓取要求任意数据包可独立解码，只适用于帧内编码（MJPEG）
+    const AVCodecDescriptor *desc = avcodec_descriptor_get(codec_ctx->codec_id);
+    grab_latest = config->grab_latest;
+    if (grab_latest && !(desc && (desc->props & AV_CODEC_PROP_INTRA_ONLY))) {
+        fprintf(stderr, "解码器 %s 不是帧内编码，改为按顺序解码\n", codec->name);
+        grab_latest = false;
+    }
+    
+    // 启用解码器多线程：默认只用切片线程降低单帧延迟；DECODE_FRAME_THREADS 开启帧线程换取吞吐（增加 线程数-1 帧延迟）
+    // 最新帧抓取时每次只送入一个数据包并立即取帧，帧线程会缓存数据包，因此只用切片线程
+    codec_ctx->thread_count = config->decode_threads;
+    codec_ctx->thread_type = grab_latest ? FF_THREAD_SLICE : DECODE_THREAD_TYPE;
+    
     // 打开解码器
     ret = avcodec_open2(codec_ctx, codec, NULL);
     if (ret < 0) {
@@ -139,6 +265,11 @@ int camera_init(camera_config_t *config) {
         return -1;
     }
     
+    // 缩放输入：MJPEG 的输出像素格式要解码后才知道，未探测时先按预设格式建立，首帧不符再重建
+    src_fmt = codec_ctx->pix_fmt != AV_PIX_FMT_NONE ? codec_ctx->pix_fmt : av_get_pix_fmt(FASTSTART_PIX_FMT);
+    src_w = codec_ctx->width;
+    src_h = codec_ctx->height;
+    
     // 分配帧缓冲区
     frame = av_frame_alloc();
     rgb_frame = av_frame_alloc();
@@ -151,68 +282,269 @@ int camera_init(camera_config_t *config) {
         return -1;
     }
     
-    // 分配RGB缓冲区
-    rgb_buffer = (uint8_t *)av_malloc(av_image_get_buffer_size(AV_PIX_FMT_RGB565, TARGET_WIDTH, TARGET_HEIGHT, 1));
-    if (!rgb_buffer) {
-        fprintf(stderr, "无法分配RGB缓冲区\n");
+    // 启动读取线程
+    if (grab_latest) {
+        if (pthread_create(&drain_tid, NULL, drain_thread, NULL) != 0) {
+            fprintf(stderr, "摄像头读取线程创建失败\n");
+            av_frame_free(&frame);
+            av_frame_free(&rgb_frame);
+            avcodec_free_context(&codec_ctx);
+            avformat_close_input(&format_ctx);
+            return -1;
+        }
+        drain_started = true;
+    }
+    return 0;
+}
+
+// 关闭采集设备与解码器
+static void close_capture(void) {
+    stop_drain();
+    
+    if (frame) {
         av_frame_free(&frame);
+        frame = NULL;
+    }
+    
+    if (rgb_frame) {
         av_frame_free(&rgb_frame);
+        rgb_frame = NULL;
+    }
+    
+    if (codec_ctx) {
         avcodec_free_context(&codec_ctx);
+        codec_ctx = NULL;
+    }
+    
+    if (format_ctx) {
         avformat_close_input(&format_ctx);
+        format_ctx = NULL;
+    }
+}
+
+// 释放缩放上下文与输出缓冲区
+static void close_output(void) {
+    if (scaler_ready) {
+        scaler_destroy(&scaler);
+        scaler_ready = false;
+    }
+    if (roi_enabled) {
+        scaler_destroy(&roi_scaler);
+        roi_enabled = false;
+    }
+    pixfmt_destroy(&converter);
+    
+    if (rgb_buffer) {
+        av_free(rgb_buffer);
+        rgb_buffer = NULL;
+    }
+}
+
+// 创建注视区域缩放上下文：采集画面中与注视区域对应的窗口 -> roi_w*roi_h RGB565
+static int open_roi_output(const camera_config_t *config) {
+    int scale = config->roi_scale > 1 ? config->roi_scale : 2;
+
+    roi_w = (config->roi_width < config->width ? config->roi_width : config->width) & ~1;
+    roi_h = (config->roi_height < config->height ? config->roi_height : config->height) & ~1;
+    periph_w = (config->width / scale) & ~1;
+    periph_h = (config->height / scale) & ~1;
+    if (roi_w < 2 || roi_h < 2 || periph_w < 2 || periph_h < 2) {
+        fprintf(stderr, "注视区域参数无效: 区域 %dx%d, 外围 %dx%d\n", roi_w, roi_h, periph_w, periph_h);
+        return -1;
+    }
+    // 注视区域按输出与裁剪窗口的比例换算到采集画面
+    roi_src_w = (int)((long)roi_w * crop_w / config->width) & ~1;
+    roi_src_h = (int)((long)roi_h * crop_h / config->height) & ~1;
+    roi_src_w = roi_src_w < 2 ? 2 : roi_src_w;
+    roi_src_h = roi_src_h < 2 ? 2 : roi_src_h;
+
+    if (scaler_init(&roi_scaler, roi_src_w, roi_src_h, src_fmt,
+                    roi_w, roi_h, pixfmt_scaler_format(PIXEL_FORMAT_RGB565),
+                    config->scale_workers) != 0) {
+        fprintf(stderr, "无法创建注视区域转换上下文\n");
+        return -1;
+    }
+    roi_enabled = true;
+    return 0;
+}
+
+// 创建缩放上下文与输出缓冲区（输出阶段），需在采集阶段之后调用
+static int open_output(const camera_config_t *config) {
+    // 缩放输出格式：RGB565/灰度直接输出，其余格式先输出平面RGB或灰度再降位深
+    enum AVPixelFormat scaled_fmt = pixfmt_scaler_format(config->pixel_format);
+    
+    // 裁剪窗口不超过采集画面，取偶数便于按色度采样对齐
+    crop_w = src_w;
+    crop_h = src_h;
+    if (config->crop_width > 0 && config->crop_height > 0) {
+        crop_w = (config->crop_width < src_w ? config->crop_width : src_w) & ~1;
+        crop_h = (config->crop_height < src_h ? config->crop_height : src_h) & ~1;
+    }
+    
+    // 注视区域编码时主缩放输出外围图像，否则输出整幅画面
+    out_w = config->width;
+    out_h = config->height;
+    if (config->roi_width > 0 && config->roi_height > 0) {
+        if (open_roi_output(config) != 0) {
+            return -1;
+        }
+        out_w = periph_w;
+        out_h = periph_h;
+    }
+    
+    if (pixfmt_init(&converter, config->pixel_format, out_w, out_h, config->dither) != 0) {
+        close_output();
+        return -1;
+    }
+    periph_size = (long)pixfmt_frame_size(config->pixel_format, out_w, out_h);
+    frame_size = periph_size + (roi_enabled ? (long)roi_w * roi_h * 2 : 0);
+    
+    // 分配RGB缓冲区
+    rgb_buffer = (uint8_t *)av_malloc(av_image_get_buffer_size(scaled_fmt, out_w, out_h, 1));
+    if (!rgb_buffer) {
+        fprintf(stderr, "无法分配RGB缓冲区\n");
+        close_output();
         return -1;
     }
     
     // 设置RGB帧的参数
     av_image_fill_arrays(rgb_frame->data, rgb_frame->linesize, rgb_buffer,
-                         AV_PIX_FMT_RGB565, TARGET_WIDTH, TARGET_HEIGHT, 1);
+                         scaled_fmt, out_w, out_h, 1);
     
-    // 初始化图像转换上下文
-    sws_ctx = sws_getContext(codec_ctx->width, codec_ctx->height, codec_ctx->pix_fmt,
-                            TARGET_WIDTH, TARGET_HEIGHT, AV_PIX_FMT_RGB565,
-                            SWS_BILINEAR, NULL, NULL, NULL);
-    if (!sws_ctx) {
+    // 初始化图像转换上下文：按水平切片分配到常驻工作线程
+    if (scaler_init(&scaler, crop_w, crop_h, src_fmt,
+                    out_w, out_h, scaled_fmt,
+                    config->scale_workers) != 0) {
         fprintf(stderr, "无法创建图像转换上下文\n");
-        av_free(rgb_buffer);
-        av_frame_free(&frame);
-        av_frame_free(&rgb_frame);
-        avcodec_free_context(&codec_ctx);
-        avformat_close_input(&format_ctx);
+        close_output();
         return -1;
     }
     
-    // 初始化帧计数器
+    scaler_ready = true;
+    return 0;
+}
+
+// 打印当前输出配置
+static void print_output(const camera_config_t *config) {
+    printf("摄像头输出: %s, 采集 %dx%d@%d (%s), 裁剪 %dx%d, 输出 %dx%d, 格式: %s%s (%ld 字节/帧), 缩放切片: %d\n", 
+           config->device, config->capture_width, config->capture_height, config->capture_fps,
+           grab_latest ? "最新帧抓取" : "顺序解码", crop_w, crop_h,
+           config->width, config->height, pixfmt_name(config->pixel_format),
+           config->dither ? "+抖动" : "", frame_size, scaler.slice_count);
+    if (roi_enabled) {
+        printf("注视区域编码: 中心 %dx%d rgb565（采集窗口 %dx%d），外围 %dx%d %s，每帧为整帧的 %ld%%\n",
+               roi_w, roi_h, roi_src_w, roi_src_h, periph_w, periph_h, pixfmt_name(config->pixel_format),
+               frame_size * 100 / (long)pixfmt_frame_size(config->pixel_format, config->width, config->height));
+    }
+}
+
+// 初始化摄像头，设置参数并打开设备
+int camera_init(camera_config_t *config) {
+    // 参数检查
+    if (!config || !config->device || config->width <= 0 || config->height <= 0 ||
+        config->capture_width <= 0 || config->capture_height <= 0 || config->capture_fps <= 0) {
+        fprintf(stderr, "摄像头配置无效\n");
+        return -1;
+    }
+    
+    // 如果已经初始化，先释放资源
+    if (camera_ready) {
+        camera_deinit();
+    }
+    
+    if (open_capture(config) != 0) {
+        return -1;
+    }
+    if (open_output(config) != 0) {
+        close_capture();
+        return -1;
+    }
+    
+    // 初始化帧计数器与统计
     frame_counter = 0;
+    pthread_mutex_lock(&latest_lock);
+    memset(&stats, 0, sizeof(stats));
+    stats.last_age_us = -1;
+    pthread_mutex_unlock(&latest_lock);
     
     // 标记摄像头已准备好
     camera_ready = true;
     config->is_initialized = true;
+    current_config = *config;
     
-    printf("摄像头初始化成功: %s, 分辨率: %dx%d\n", 
-           config->device, TARGET_WIDTH, TARGET_HEIGHT);
-    
+    print_output(config);
     return 0;
 }
 
-// 从摄像头获取一帧图像，转换为240*240*16位RGB格式
-int camera_get_frame(unsigned char **buffer, long *size) {
-    int ret;
-    int got_frame = 0;
-    struct timeval start, end;
-    long elapsed;
-    
-    // 检查摄像头是否已初始化
-    if (!camera_ready) {
-        fprintf(stderr, "摄像头未初始化\n");
+// 运行中修改摄像头配置，只重建受影响的阶段
+int camera_reconfigure(camera_config_t *config) {
+    if (!config || !config->device || config->width <= 0 || config->height <= 0 ||
+        config->capture_width <= 0 || config->capture_height <= 0 || config->capture_fps <= 0) {
+        fprintf(stderr, "摄像头配置无效\n");
         return -1;
     }
+    if (!camera_ready) {
+        return camera_init(config);
+    }
     
-    // 记录开始时间
-    gettimeofday(&start, NULL);
+    // 采集设备、采集分辨率或解码线程变化：需要重新打开设备
+    if (capture_lost || strcmp(config->device, current_config.device) != 0 ||
+        config->capture_width != current_config.capture_width ||
+        config->capture_height != current_config.capture_height ||
+        config->capture_fps != current_config.capture_fps ||
+        config->grab_latest != current_config.grab_latest ||
+        config->decode_threads != current_config.decode_threads) {
+        camera_config_t previous = current_config;
+        printf("重新打开摄像头（采集参数变化）\n");
+        if (camera_init(config) != 0) {
+            if (camera_init(&previous) != 0) {
+                fprintf(stderr, "摄像头恢复原配置也失败，摄像头已关闭，等待下一次重新配置\n");
+                return -2;
+            }
+            return -1;
+        }
+        return 0;
+    }
+    
+    // 输出分辨率、像素格式、裁剪/注视区域或切片数变化：只重建缩放与输出缓冲区，设备与解码器保持打开
+    if (config->width != current_config.width || config->height != current_config.height ||
+        config->pixel_format != current_config.pixel_format ||
+        config->dither != current_config.dither ||
+        config->crop_width != current_config.crop_width ||
+        config->crop_height != current_config.crop_height ||
+        config->roi_width != current_config.roi_width ||
+        config->roi_height != current_config.roi_height ||
+        config->roi_scale != current_config.roi_scale ||
+        config->scale_workers != current_config.scale_workers) {
+        close_output();
+        if (open_output(config) != 0) {
+            fprintf(stderr, "输出阶段重建失败，恢复原配置\n");
+            if (open_output(&current_config) != 0) {
+                fprintf(stderr, "输出阶段恢复原配置也失败，摄像头已关闭，等待下一次重新配置\n");
+                close_capture();
+                camera_ready = false;
+                return -2;
+            }
+            return -1;
+        }
+        current_config = *config;
+        print_output(config);
+    }
+    config->is_initialized = true;
+    return 0;
+}
+
+// 顺序模式：依次读取数据包并解码，直到得到一帧
+static int decode_next_frame(void) {
+    int ret;
+    int got_frame = 0;
     
     // 读取帧直到获取到一个完整的帧
     while (!got_frame) {
         // 读取一个数据包
+        TRACE_BEGIN("av_read_frame");
         ret = av_read_frame(format_ctx, &packet);
+        TRACE_END("av_read_frame");
         if (ret < 0) {
             fprintf(stderr, "读取帧失败\n");
             return -1;
@@ -221,8 +553,10 @@ int camera_get_frame(unsigned char **buffer, long *size) {
         // 检查是否是视频流的数据包
         if (packet.stream_index == video_stream_index) {
             // 发送数据包到解码器
+            TRACE_BEGIN("decode");
             ret = avcodec_send_packet(codec_ctx, &packet);
             if (ret < 0) {
+                TRACE_END("decode");
                 av_packet_unref(&packet);
                 fprintf(stderr, "发送数据包到解码器失败\n");
                 return -1;
@@ -230,6 +564,7 @@ int camera_get_frame(unsigned char **buffer, long *size) {
             
             // 从解码器接收帧
             ret = avcodec_receive_frame(codec_ctx, frame);
+            TRACE_END("decode");
             if (ret == 0) {
                 got_frame = 1;
             } else if (ret == AVERROR(EAGAIN)) {
@@ -245,27 +580,191 @@ int camera_get_frame(unsigned char **buffer, long *size) {
         
         // 释放数据包
         av_packet_unref(&packet);
-        
-        // 如果获取到帧，跳出循环
-        if (got_frame) {
-            break;
+    }
+    return 0;
+}
+
+// 最新帧抓取模式：等待读取线程的最新数据包，只解码这一个
+static int decode_latest_frame(void) {
+    struct timespec deadline;
+    int ret = 0;
+    
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 1;
+    
+    pthread_mutex_lock(&latest_lock);
+    while (!latest_valid && drain_error == 0 && ret != ETIMEDOUT) {
+        ret = pthread_cond_timedwait(&latest_cond, &latest_lock, &deadline);
+    }
+    if (!latest_valid) {
+        int error = drain_error;
+        pthread_mutex_unlock(&latest_lock);
+        if (error) {
+            char err_buf[128];
+            av_strerror(error, err_buf, sizeof(err_buf));
+            fprintf(stderr, "读取帧失败，读取线程已退出: %s\n", err_buf);
+            return -2;
+        }
+        fprintf(stderr, "等待摄像头数据超时\n");
+        return -1;
+    }
+    av_packet_move_ref(&packet, &latest_packet);
+    latest_valid = false;
+    pthread_mutex_unlock(&latest_lock);
+    
+    // 帧内编码一包即一帧，切片线程解码不缓存数据包
+    TRACE_BEGIN("decode");
+    ret = avcodec_send_packet(codec_ctx, &packet);
+    av_packet_unref(&packet);
+    if (ret < 0) {
+        TRACE_END("decode");
+        fprintf(stderr, "发送数据包到解码器失败\n");
+        return -1;
+    }
+    ret = avcodec_receive_frame(codec_ctx, frame);
+    TRACE_END("decode");
+    if (ret < 0) {
+        fprintf(stderr, "从解码器接收帧失败\n");
+        return -1;
+    }
+    return 0;
+}
+
+// 记录解码完成时的帧龄（摄像头时间戳为绝对时间，单位微秒）
+static void update_frame_age(void) {
+    int64_t age = -1;
+    if (frame->pts != AV_NOPTS_VALUE) {
+        age = av_gettime() - frame->pts;
+    }
+    
+    pthread_mutex_lock(&latest_lock);
+    stats.decoded++;
+    stats.last_age_us = age;
+    if (age >= 0) {
+        stats.aged++;
+        stats.total_age_us += age;
+        if (age > stats.max_age_us) {
+            stats.max_age_us = age;
+        }
+    }
+    pthread_mutex_unlock(&latest_lock);
+}
+
+// 重新打开采集阶段（设备与解码器）并重建输出阶段：读取线程因设备错误退出或输出阶段重建失败后恢复取帧
+static int reopen_capture(void) {
+    close_output();
+    close_capture();
+    if (open_capture(&current_config) != 0 || open_output(&current_config) != 0) {
+        close_output();
+        close_capture();
+        capture_lost = true;
+        fprintf(stderr, "重新打开采集设备失败，下一帧重试\n");
+        return -1;
+    }
+    capture_lost = false;
+    printf("采集设备已重新打开\n");
+    return 0;
+}
+
+// 从摄像头获取一帧图像，转换为配置的分辨率与像素格式
+int camera_get_frame(unsigned char **buffer, long *size) {
+    struct timeval start, end;
+    long elapsed;
+    
+    // 检查摄像头是否已初始化
+    if (!camera_ready) {
+        fprintf(stderr, "摄像头未初始化\n");
+        return -1;
+    }
+    
+    // 记录开始时间
+    gettimeofday(&start, NULL);
+    
+    // 采集阶段因读取错误或输出阶段重建失败关闭：每次取帧时重试打开（失败时由调用者按连续失败次数暂停）
+    if (capture_lost && reopen_capture() != 0) {
+        return -1;
+    }
+    
+    int ret = grab_latest ? decode_latest_frame() : decode_next_frame();
+    if (ret == -2) {
+        // 读取线程不会自行重启，重新打开设备后从下一帧继续
+        reopen_capture();
+        return -1;
+    }
+    if (ret != 0) {
+        return -1;
+    }
+    update_frame_age();
+    
+    // 解码输出与缩放输入不符（快速启动的预设格式有误或设备改变了分辨率）：按实际输出重建输出阶段
+    if (frame->format != src_fmt || frame->width != src_w || frame->height != src_h) {
+        printf("解码输出 %s %dx%d 与缩放输入 %s %dx%d 不符，重建输出阶段\n",
+               av_get_pix_fmt_name((enum AVPixelFormat)frame->format), frame->width, frame->height,
+               av_get_pix_fmt_name(src_fmt), src_w, src_h);
+        close_output();
+        src_fmt = (enum AVPixelFormat)frame->format;
+        src_w = frame->width;
+        src_h = frame->height;
+        if (open_output(&current_config) != 0) {
+            // 与读取出错相同：关闭采集阶段，之后每次取帧时重新打开（由调用者按连续失败次数暂停）
+            fprintf(stderr, "输出阶段重建失败，关闭采集设备，下一帧重试\n");
+            close_output();
+            close_capture();
+            capture_lost = true;
+            return -1;
         }
     }
     
-    // 转换图像格式为RGB565
-    sws_scale(sws_ctx, (const uint8_t * const*)frame->data, frame->linesize, 0,
-              codec_ctx->height, rgb_frame->data, rgb_frame->linesize);
+    // 缩放并转换颜色空间；裁剪时窗口默认居中，电子云台按角度指令偏移
+    if (frame->width < crop_w || frame->height < crop_h) {
+        fprintf(stderr, "解码帧尺寸 %dx%d 小于缩放输入 %dx%d\n", frame->width, frame->height, crop_w, crop_h);
+        return -1;
+    }
+    int crop_x = (frame->width - crop_w) / 2;
+    int crop_y = (frame->height - crop_h) / 2;
+    if (crop_w < frame->width || crop_h < frame->height) {
+        int dx, dy;
+        eptz_get_offset(&dx, &dy);
+        crop_x += dx;
+        crop_y += dy;
+        crop_x = crop_x < 0 ? 0 : (crop_x > frame->width - crop_w ? frame->width - crop_w : crop_x);
+        crop_y = crop_y < 0 ? 0 : (crop_y > frame->height - crop_h ? frame->height - crop_h : crop_y);
+    }
+    scaler_run_at(&scaler, (const uint8_t * const*)frame->data, frame->linesize, crop_x, crop_y,
+                  rgb_frame->data, rgb_frame->linesize);
     
     // 分配输出缓冲区
-    *size = TARGET_SIZE;
+    *size = frame_size;
     *buffer = (unsigned char *)malloc(*size);
     if (!*buffer) {
         fprintf(stderr, "无法分配输出缓冲区\n");
         return -1;
     }
     
-    // 复制RGB565数据到输出缓冲区
-    memcpy(*buffer, rgb_frame->data[0], *size);
+    // 转换为目标像素格式并写入输出缓冲区（注视区域编码时为外围图像）
+    TRACE_BEGIN("pixfmt_convert");
+    pixfmt_convert(&converter, rgb_frame->data, rgb_frame->linesize, *buffer);
+    TRACE_END("pixfmt_convert");
+    
+    // 注视区域：从采集画面中对应的窗口直接缩放为 RGB565，写在外围图像之后
+    if (roi_enabled) {
+        uint8_t *roi_dst[4] = { *buffer + periph_size, NULL, NULL, NULL };
+        int roi_stride[4] = { roi_w * 2, 0, 0, 0 };
+        int src_x, src_y;
+        
+        fovea_roi_origin(current_config.width, current_config.height, roi_w, roi_h,
+                         &last_roi.x, &last_roi.y);
+        src_x = crop_x + (int)((long)last_roi.x * crop_w / current_config.width);
+        src_y = crop_y + (int)((long)last_roi.y * crop_h / current_config.height);
+        src_x = src_x > frame->width - roi_src_w ? frame->width - roi_src_w : src_x;
+        src_y = src_y > frame->height - roi_src_h ? frame->height - roi_src_h : src_y;
+        scaler_run_at(&roi_scaler, (const uint8_t * const*)frame->data, frame->linesize, src_x, src_y,
+                      roi_dst, roi_stride);
+        last_roi.width = roi_w;
+        last_roi.height = roi_h;
+        last_roi.periph_width = periph_w;
+        last_roi.periph_height = periph_h;
+    }
     
     // 增加帧计数器
     frame_counter++;
@@ -274,14 +773,38 @@ int camera_get_frame(unsigned char **buffer, long *size) {
     gettimeofday(&end, NULL);
     elapsed = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_usec - start.tv_usec) / 1000;
     
-    // 打印帧率信息（每30帧）
+    // 打印帧率与帧龄信息（每30帧）
     if (frame_counter % 30 == 0) {
-        printf("摄像头帧率: %.2f fps (处理时间: %ld ms)\n", 1000.0 / elapsed, elapsed);
+        camera_stats_t snapshot;
+        camera_get_stats(&snapshot);
+        printf("摄像头帧率: %.2f fps (处理时间: %ld ms), 帧龄: 当前 %lld ms, 平均 %lld ms, 最大 %lld ms, "
+               "已解码 %llu, 跳过 %llu\n",
+               1000.0 / (elapsed > 0 ? elapsed : 1), elapsed,
+               (long long)(snapshot.last_age_us / 1000),
+               (long long)(snapshot.aged ? snapshot.total_age_us / (int64_t)snapshot.aged / 1000 : -1),
+               (long long)(snapshot.max_age_us / 1000),
+               (unsigned long long)snapshot.decoded, (unsigned long long)snapshot.skipped);
     }
     
     return 0;
 }
 
+// 最近一帧的注视区域布局
+bool camera_get_roi(camera_roi_t *roi) {
+    if (!camera_ready || !roi_enabled) {
+        return false;
+    }
+    *roi = last_roi;
+    return true;
+}
+
+// 获取采集统计
+void camera_get_stats(camera_stats_t *out) {
+    pthread_mutex_lock(&latest_lock);
+    *out = stats;
+    pthread_mutex_unlock(&latest_lock);
+}
+
 // 关闭摄像头，释放资源
 void camera_deinit(void) {
     if (!camera_ready) {
@@ -289,36 +812,10 @@ void camera_deinit(void) {
     }
     
     // 释放资源
-    if (sws_ctx) {
-        sws_freeContext(sws_ctx);
-        sws_ctx = NULL;
-    }
-    
-    if (rgb_buffer) {
-        av_free(rgb_buffer);
-        rgb_buffer = NULL;
-    }
-    
-    if (frame) {
-        av_frame_free(&frame);
-        frame = NULL;
-    }
-    
-    if (rgb_frame) {
-        av_frame_free(&rgb_frame);
-        rgb_frame = NULL;
-    }
-    
-    if (codec_ctx) {
-        avcodec_free_context(&codec_ctx);
-        codec_ctx = NULL;
-    }
-    
-    if (format_ctx) {
-        avformat_close_input(&format_ctx);
-        format_ctx = NULL;
-    }
+    close_output();
+    close_capture();
     
+    capture_lost = false;
     camera_ready = false;
     printf("摄像头已关闭\n");
 }
@@ -0,0 +1,293 @@
+#include "camera/pixfmt.h"
+#include "config/config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 16 字节向量（GCC 向量扩展，ARM 上编译为 NEON，x86 上为 SSE2）
+typedef uint8_t v16u8 __attribute__((vector_size(16)));
+
+static const char *format_names[PIXEL_FORMAT_COUNT] = {
+    "rgb565", "rgb332", "gray8", "gray4", "pal8"
+};
+
+// 8x8 Bayer 有序抖动阈值矩阵（0~63）
+static const uint8_t bayer8[8][8] = {
+    { 0, 32,  8, 40,  2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44,  4, 36, 14, 46,  6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    { 3, 35, 11, 43,  1, 33,  9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47,  7, 39, 13, 45,  5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21},
+};
+
+// 获取格式名称
+const char *pixfmt_name(pixel_format_t format) {
+    if (format < 0 || format >= PIXEL_FORMAT_COUNT) {
+        return "unknown";
+    }
+    return format_names[format];
+}
+
+// 按名称查找格式
+int pixfmt_from_name(const char *name) {
+    for (int i = 0; name && i < PIXEL_FORMAT_COUNT; i++) {
+        if (strcmp(name, format_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 缩放阶段输出的中间格式：彩色降位深用平面RGB，便于逐分量向量化处理
+enum AVPixelFormat pixfmt_scaler_format(pixel_format_t format) {
+    switch (format) {
+    case PIXEL_FORMAT_GRAY8:
+    case PIXEL_FORMAT_GRAY4:
+        return AV_PIX_FMT_GRAY8;
+    case PIXEL_FORMAT_RGB332:
+    case PIXEL_FORMAT_PAL8:
+        return AV_PIX_FMT_GBRP;
+    default:
+        return AV_PIX_FMT_RGB565;
+    }
+}
+
+// 每行字节数
+size_t pixfmt_row_bytes(pixel_format_t format, int width) {
+    switch (format) {
+    case PIXEL_FORMAT_RGB565:
+        return (size_t)width * 2;
+    case PIXEL_FORMAT_GRAY4:
+        return (size_t)(width + 1) / 2;
+    default:
+        return (size_t)width;
+    }
+}
+
+// 帧数据前附带的调色板字节数
+size_t pixfmt_palette_bytes(pixel_format_t format) {
+    return format == PIXEL_FORMAT_PAL8 ? PIXFMT_PALETTE_SIZE * 3 : 0;
+}
+
+// 一帧数据总字节数
+size_t pixfmt_frame_size(pixel_format_t format, int width, int height) {
+    return pixfmt_palette_bytes(format) + pixfmt_row_bytes(format, width) * height;
+}
+
+/**
+ * 一行量化到 bits 位（2~4）：q = min((p + d) >> (8 - bits), 2^bits - 1)
+ * d 为抖动阈值（关闭抖动时为半个量化步长，即四舍五入）。
+ * 向量路径用 (p >> 1) + (d >> 1) + (p & d & 1) 计算 (p + d) / 2，全程8位无溢出。
+ */
+static void quantize_row(const uint8_t *src, uint8_t *dst, int width, int bits, int y, bool dither) {
+    uint8_t pattern[16];
+    v16u8 d, d_half;
+    int x = 0;
+
+    for (int i = 0; i < 16; i++) {
+        pattern[i] = dither ? (uint8_t)(bayer8[y & 7][i & 7] >> (bits - 2)) : (uint8_t)(128 >> bits);
+    }
+    memcpy(&d, pattern, sizeof(d));
+    d_half = d >> 1;
+
+    for (; x + 16 <= width; x += 16) {
+        v16u8 p, q;
+        memcpy(&p, src + x, sizeof(p));
+        q = ((p >> 1) + d_half + (p & d & 1)) >> (7 - bits);
+        q -= q >> bits;
+        memcpy(dst + x, &q, sizeof(q));
+    }
+    for (; x < width; x++) {
+        int q = (src[x] + pattern[x & 15]) >> (8 - bits);
+        dst[x] = (uint8_t)(q - (q >> bits));
+    }
+}
+
+// 用当前帧重新生成自适应调色板：取出现次数最多的 RGB444 颜色，颜色值取各自的平均值
+static void update_palette(pixfmt_ctx *ctx, uint8_t *const src[], const int src_stride[]) {
+    uint32_t *hist = ctx->hist; // 每个 RGB444 值：计数、R/G/B 累加
+    int16_t slot[4096];         // 被选入调色板的 RGB444 值对应的索引，-1 为未选中
+    int used = 0;
+
+    memset(hist, 0, sizeof(uint32_t) * 4096 * 4);
+    for (int y = 0; y < ctx->height; y++) {
+        const uint8_t *g = src[0] + (size_t)y * src_stride[0];
+        const uint8_t *b = src[1] + (size_t)y * src_stride[1];
+        const uint8_t *r = src[2] + (size_t)y * src_stride[2];
+        const uint16_t *bins = ctx->bins + (size_t)y * ctx->width;
+        for (int x = 0; x < ctx->width; x++) {
+            uint32_t *h = &hist[bins[x] * 4];
+            h[0]++;
+            h[1] += r[x];
+            h[2] += g[x];
+            h[3] += b[x];
+        }
+    }
+
+    // 依次选出计数最多的颜色，选中的 RGB444 值直接映射到自己的调色板项
+    memset(slot, 0xff, sizeof(slot));
+    while (used < PIXFMT_PALETTE_SIZE) {
+        int best = -1;
+        for (int i = 0; i < 4096; i++) {
+            if (hist[i * 4] > 0 && (best < 0 || hist[i * 4] > hist[best * 4])) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        uint32_t *h = &hist[best * 4];
+        ctx->palette[used * 3 + 0] = (uint8_t)(h[1] / h[0]);
+        ctx->palette[used * 3 + 1] = (uint8_t)(h[2] / h[0]);
+        ctx->palette[used * 3 + 2] = (uint8_t)(h[3] / h[0]);
+        h[0] = 0;
+        slot[best] = (int16_t)used;
+        used++;
+    }
+    if (used == 0) {
+        used = 1;
+        memset(ctx->palette, 0, 3);
+    }
+    memset(ctx->palette + used * 3, 0, (PIXFMT_PALETTE_SIZE - used) * 3);
+    ctx->palette_used = used;
+
+    // 其余 RGB444 值映射到欧氏距离最近的调色板项
+    for (int i = 0; i < 4096; i++) {
+        if (slot[i] >= 0) {
+            ctx->lut[i] = (uint8_t)slot[i];
+            continue;
+        }
+        int r = ((i >> 8) & 15) * 17, g = ((i >> 4) & 15) * 17, b = (i & 15) * 17;
+        int best = 0, best_dist = 1 << 30;
+        for (int p = 0; p < used; p++) {
+            int dr = r - ctx->palette[p * 3], dg = g - ctx->palette[p * 3 + 1], db = b - ctx->palette[p * 3 + 2];
+            int dist = dr * dr + dg * dg + db * db;
+            if (dist < best_dist) {
+                best_dist = dist;
+                best = p;
+            }
+        }
+        ctx->lut[i] = (uint8_t)best;
+    }
+}
+
+// 初始化像素格式转换
+int pixfmt_init(pixfmt_ctx *ctx, pixel_format_t format, int width, int height, bool dither) {
+    memset(ctx, 0, sizeof(pixfmt_ctx));
+    if (format < 0 || format >= PIXEL_FORMAT_COUNT || width <= 0 || height <= 0) {
+        fprintf(stderr, "像素格式参数无效\n");
+        return -1;
+    }
+    ctx->format = format;
+    ctx->width = width;
+    ctx->height = height;
+    ctx->dither = dither;
+
+    for (int i = 0; i < 3; i++) {
+        ctx->rows[i] = (uint8_t *)malloc(width);
+        if (!ctx->rows[i]) {
+            fprintf(stderr, "内存分配失败\n");
+            pixfmt_destroy(ctx);
+            return -1;
+        }
+    }
+    if (format == PIXEL_FORMAT_PAL8) {
+        ctx->lut = (uint8_t *)calloc(4096, 1);
+        ctx->bins = (uint16_t *)malloc(sizeof(uint16_t) * width * height);
+        ctx->hist = (uint32_t *)malloc(sizeof(uint32_t) * 4096 * 4);
+        if (!ctx->lut || !ctx->bins || !ctx->hist) {
+            fprintf(stderr, "内存分配失败\n");
+            pixfmt_destroy(ctx);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// 把缩放输出转换为目标格式
+int pixfmt_convert(pixfmt_ctx *ctx, uint8_t *const src[], const int src_stride[], uint8_t *dst) {
+    const int w = ctx->width;
+    const size_t row_bytes = pixfmt_row_bytes(ctx->format, w);
+    uint8_t **rows = ctx->rows;
+
+    switch (ctx->format) {
+    case PIXEL_FORMAT_RGB565:
+    case PIXEL_FORMAT_GRAY8:
+        // 缩放已直接输出目标格式，仅去掉行跨度填充
+        for (int y = 0; y < ctx->height; y++) {
+            memcpy(dst + y * row_bytes, src[0] + (size_t)y * src_stride[0], row_bytes);
+        }
+        break;
+
+    case PIXEL_FORMAT_GRAY4:
+        for (int y = 0; y < ctx->height; y++) {
+            uint8_t *out = dst + y * row_bytes;
+            quantize_row(src[0] + (size_t)y * src_stride[0], rows[0], w, 4, y, ctx->dither);
+            for (int x = 0; x + 1 < w; x += 2) {
+                out[x / 2] = (uint8_t)((rows[0][x] << 4) | rows[0][x + 1]);
+            }
+            if (w & 1) {
+                out[w / 2] = (uint8_t)(rows[0][w - 1] << 4);
+            }
+        }
+        break;
+
+    case PIXEL_FORMAT_RGB332:
+        // GBRP 平面顺序为 G、B、R
+        for (int y = 0; y < ctx->height; y++) {
+            uint8_t *out = dst + y * row_bytes;
+            quantize_row(src[2] + (size_t)y * src_stride[2], rows[0], w, 3, y, ctx->dither);
+            quantize_row(src[0] + (size_t)y * src_stride[0], rows[1], w, 3, y, ctx->dither);
+            quantize_row(src[1] + (size_t)y * src_stride[1], rows[2], w, 2, y, ctx->dither);
+            for (int x = 0; x < w; x++) {
+                out[x] = (uint8_t)((rows[0][x] << 5) | (rows[1][x] << 2) | rows[2][x]);
+            }
+        }
+        break;
+
+    case PIXEL_FORMAT_PAL8: {
+        uint8_t *indices = dst + pixfmt_palette_bytes(ctx->format);
+        for (int y = 0; y < ctx->height; y++) {
+            uint16_t *bins = ctx->bins + (size_t)y * w;
+            quantize_row(src[2] + (size_t)y * src_stride[2], rows[0], w, 4, y, ctx->dither);
+            quantize_row(src[0] + (size_t)y * src_stride[0], rows[1], w, 4, y, ctx->dither);
+            quantize_row(src[1] + (size_t)y * src_stride[1], rows[2], w, 4, y, ctx->dither);
+            for (int x = 0; x < w; x++) {
+                bins[x] = (uint16_t)((rows[0][x] << 8) | (rows[1][x] << 4) | rows[2][x]);
+            }
+        }
+        // 每 PALETTE_UPDATE_FRAMES 帧更新一次调色板，其余帧只查表
+        if (ctx->frame_count % PALETTE_UPDATE_FRAMES == 0) {
+            update_palette(ctx, src, src_stride);
+        }
+        memcpy(dst, ctx->palette, sizeof(ctx->palette));
+        for (size_t i = 0; i < (size_t)w * ctx->height; i++) {
+            indices[i] = ctx->lut[ctx->bins[i]];
+        }
+        break;
+    }
+
+    default:
+        return -1;
+    }
+
+    ctx->frame_count++;
+    return 0;
+}
+
+// 释放资源
+void pixfmt_destroy(pixfmt_ctx *ctx) {
+    for (int i = 0; i < 3; i++) {
+        free(ctx->rows[i]);
+        ctx->rows[i] = NULL;
+    }
+    free(ctx->lut);
+    free(ctx->bins);
+    free(ctx->hist);
+    ctx->lut = NULL;
+    ctx->bins = NULL;
+    ctx->hist = NULL;
+}
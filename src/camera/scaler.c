@@ -0,0 +1,270 @@
+#include "camera/scaler.h"
+#include "config/config.h"
+#include "thread_profile/thread_profile.h"
+#include "trace/trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+
+static int gcd(int a, int b) {
+    while (b) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static int lcm(int a, int b) {
+    return a / gcd(a, b) * b;
+}
+
+// 执行单个切片：在切片自己的上下文中缩放，再把不含边距的行复制到输出
+static void run_slice(scaler_ctx *ctx, int index) {
+    scaler_slice_t *slice = &ctx->slices[index];
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(ctx->src_fmt);
+    const uint8_t *src[4] = {NULL, NULL, NULL, NULL};
+
+    TRACE_BEGIN("sws_scale");
+    if (ctx->slice_count == 1) {
+        sws_scale(slice->sws, ctx->src, ctx->src_stride, 0, ctx->src_h, ctx->dst, ctx->dst_stride);
+        TRACE_END("sws_scale");
+        return;
+    }
+
+    // 输入指针偏移到切片起始行，色度平面按垂直采样比例换算（无拷贝）
+    for (int p = 0; p < 4 && ctx->src[p]; p++) {
+        int shift = (p == 1 || p == 2) ? desc->log2_chroma_h : 0;
+        src[p] = ctx->src[p] + (size_t)(slice->src_y >> shift) * ctx->src_stride[p];
+    }
+    sws_scale(slice->sws, src, ctx->src_stride, 0, slice->src_h,
+              slice->scratch, slice->scratch_stride);
+
+    // 丢弃边距行，只写回本切片负责的行，各切片写入互不重叠
+    int skip = slice->dst_y - slice->ext_y;
+    for (int p = 0; p < 4 && ctx->dst[p]; p++) {
+        int bytes = av_image_get_linesize(ctx->dst_fmt, ctx->dst_w, p);
+        if (bytes <= 0) {
+            break;
+        }
+        for (int y = 0; y < slice->dst_h; y++) {
+            memcpy(ctx->dst[p] + (size_t)(slice->dst_y + y) * ctx->dst_stride[p],
+                   slice->scratch[p] + (size_t)(skip + y) * slice->scratch_stride[p], bytes);
+        }
+    }
+    TRACE_END("sws_scale");
+}
+
+// 常驻工作线程：等待新任务代数，处理自己的切片后报告完成
+static void *worker_thread(void *arg) {
+    scaler_worker_t *worker = (scaler_worker_t *)arg;
+    scaler_ctx *ctx = worker->ctx;
+    unsigned int seen = 0;
+
+    if (THREAD_PROFILE_ENABLE) {
+        thread_profile_apply(THREAD_ROLE_CAPTURE);
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+    for (;;) {
+        while (!ctx->stop && ctx->generation == seen) {
+            pthread_cond_wait(&ctx->start_cond, &ctx->lock);
+        }
+        if (ctx->stop) {
+            break;
+        }
+        seen = ctx->generation;
+        pthread_mutex_unlock(&ctx->lock);
+
+        run_slice(ctx, worker->index);
+
+        pthread_mutex_lock(&ctx->lock);
+        if (--ctx->pending == 0) {
+            pthread_cond_signal(&ctx->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&ctx->lock);
+    return NULL;
+}
+
+/**
+ * 计算切片边界
+ * 边界行需满足：对应的输入行为整数且落在色度行边界上；相对偏移为8的倍数，
+ * 使 RGB565 等输出格式的有序抖动相位与整帧一致。
+ */
+static int plan_slices(scaler_ctx *ctx, int workers) {
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(ctx->src_fmt);
+    int cv = desc ? desc->log2_chroma_h : 0;
+    int step = (ctx->dst_h << cv) / gcd(ctx->src_h, ctx->dst_h << cv);
+    int margin, count = 0, prev = 0;
+
+    step = lcm(step, 8);
+    margin = (SCALER_SLICE_MARGIN + step - 1) / step * step;
+    if (workers > SCALER_MAX_WORKERS) {
+        workers = SCALER_MAX_WORKERS;
+    }
+    if (workers <= 1 || step * 2 > ctx->dst_h) {
+        workers = 1;
+    }
+
+    for (int i = 1; i <= workers; i++) {
+        int end = (i == workers) ? ctx->dst_h : (i * ctx->dst_h / workers) / step * step;
+        if (end <= prev) {
+            continue;
+        }
+        scaler_slice_t *slice = &ctx->slices[count++];
+        slice->dst_y = prev;
+        slice->dst_h = end - prev;
+        if (workers == 1) {
+            slice->ext_y = 0;
+            slice->ext_h = ctx->dst_h;
+        } else {
+            int ext_end = (end + margin > ctx->dst_h) ? ctx->dst_h : end + margin;
+            slice->ext_y = (prev - margin < 0) ? 0 : prev - margin;
+            slice->ext_h = ext_end - slice->ext_y;
+        }
+        slice->src_y = (int)((int64_t)slice->ext_y * ctx->src_h / ctx->dst_h);
+        slice->src_h = (int)((int64_t)(slice->ext_y + slice->ext_h) * ctx->src_h / ctx->dst_h) - slice->src_y;
+        prev = end;
+    }
+    return count;
+}
+
+// 初始化切片并行缩放上下文
+int scaler_init(scaler_ctx *ctx,
+                int src_w, int src_h, enum AVPixelFormat src_fmt,
+                int dst_w, int dst_h, enum AVPixelFormat dst_fmt,
+                int workers) {
+    memset(ctx, 0, sizeof(scaler_ctx));
+    ctx->src_w = src_w;
+    ctx->src_h = src_h;
+    ctx->src_fmt = src_fmt;
+    ctx->dst_w = dst_w;
+    ctx->dst_h = dst_h;
+    ctx->dst_fmt = dst_fmt;
+    pthread_mutex_init(&ctx->lock, NULL);
+    pthread_cond_init(&ctx->start_cond, NULL);
+    pthread_cond_init(&ctx->done_cond, NULL);
+
+    if (src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0) {
+        fprintf(stderr, "缩放参数无效\n");
+        scaler_destroy(ctx);
+        return -1;
+    }
+
+    ctx->slice_count = plan_slices(ctx, workers);
+    for (int i = 0; i < ctx->slice_count; i++) {
+        scaler_slice_t *slice = &ctx->slices[i];
+        slice->sws = sws_getContext(src_w, slice->src_h, src_fmt,
+                                    dst_w, slice->ext_h, dst_fmt,
+                                    SWS_BILINEAR, NULL, NULL, NULL);
+        if (!slice->sws) {
+            fprintf(stderr, "无法创建图像转换上下文\n");
+            scaler_destroy(ctx);
+            return -1;
+        }
+        if (ctx->slice_count > 1 &&
+            av_image_alloc(slice->scratch, slice->scratch_stride, dst_w, slice->ext_h, dst_fmt, 16) < 0) {
+            fprintf(stderr, "无法分配切片缓冲区\n");
+            scaler_destroy(ctx);
+            return -1;
+        }
+    }
+
+    // 切片0由调用线程处理，其余切片各有一个常驻线程，运行中不再创建线程
+    for (int i = 1; i < ctx->slice_count; i++) {
+        ctx->workers[i].ctx = ctx;
+        ctx->workers[i].index = i;
+        if (pthread_create(&ctx->threads[i], NULL, worker_thread, &ctx->workers[i]) != 0) {
+            fprintf(stderr, "缩放工作线程创建失败\n");
+            scaler_destroy(ctx);
+            return -1;
+        }
+        ctx->thread_count = i;
+    }
+    return 0;
+}
+
+// 对一帧执行格式转换与缩放
+int scaler_run(scaler_ctx *ctx,
+               const uint8_t *const src[], const int src_stride[],
+               uint8_t *const dst[], const int dst_stride[]) {
+    return scaler_run_at(ctx, src, src_stride, 0, 0, dst, dst_stride);
+}
+
+// 从 (x, y) 处取窗口缩放
+int scaler_run_at(scaler_ctx *ctx,
+                  const uint8_t *const src[], const int src_stride[], int x, int y,
+                  uint8_t *const dst[], const int dst_stride[]) {
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(ctx->src_fmt);
+
+    if (ctx->slice_count == 0 || !desc) {
+        return -1;
+    }
+
+    // 窗口起点对齐到色度采样边界，各平面按自己的采样比例偏移
+    x &= ~((1 << desc->log2_chroma_w) - 1);
+    y &= ~((1 << desc->log2_chroma_h) - 1);
+    for (int p = 0; p < 4; p++) {
+        int shift = (p == 1 || p == 2) ? desc->log2_chroma_h : 0;
+        int x_bytes = x > 0 ? av_image_get_linesize(ctx->src_fmt, x, p) : 0;
+        ctx->crop_src[p] = src[p] ? src[p] + (size_t)(y >> shift) * src_stride[p] + (x_bytes > 0 ? x_bytes : 0) : NULL;
+    }
+
+    ctx->src = ctx->crop_src;
+    ctx->src_stride = src_stride;
+    ctx->dst = dst;
+    ctx->dst_stride = dst_stride;
+
+    if (ctx->slice_count > 1) {
+        pthread_mutex_lock(&ctx->lock);
+        ctx->pending = ctx->slice_count - 1;
+        ctx->generation++;
+        pthread_cond_broadcast(&ctx->start_cond);
+        pthread_mutex_unlock(&ctx->lock);
+    }
+
+    run_slice(ctx, 0);
+
+    if (ctx->slice_count > 1) {
+        pthread_mutex_lock(&ctx->lock);
+        while (ctx->pending > 0) {
+            pthread_cond_wait(&ctx->done_cond, &ctx->lock);
+        }
+        pthread_mutex_unlock(&ctx->lock);
+    }
+    return 0;
+}
+
+// 停止工作线程并释放资源
+void scaler_destroy(scaler_ctx *ctx) {
+    if (ctx->thread_count > 0) {
+        pthread_mutex_lock(&ctx->lock);
+        ctx->stop = true;
+        pthread_cond_broadcast(&ctx->start_cond);
+        pthread_mutex_unlock(&ctx->lock);
+        for (int i = 1; i <= ctx->thread_count; i++) {
+            pthread_join(ctx->threads[i], NULL);
+        }
+        ctx->thread_count = 0;
+    }
+    if (ctx->src_w > 0) {
+        pthread_mutex_destroy(&ctx->lock);
+        pthread_cond_destroy(&ctx->start_cond);
+        pthread_cond_destroy(&ctx->done_cond);
+    }
+
+    for (int i = 0; i < SCALER_MAX_WORKERS; i++) {
+        scaler_slice_t *slice = &ctx->slices[i];
+        if (slice->sws) {
+            sws_freeContext(slice->sws);
+            slice->sws = NULL;
+        }
+        if (slice->scratch[0]) {
+            av_freep(&slice->scratch[0]);
+        }
+    }
+    ctx->slice_count = 0;
+    ctx->src_w = 0;
+}
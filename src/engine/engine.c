@@ -1,4 +1,14 @@
 #include "engine/engine.h"
+#include "recorder/recorder.h"
+#include "sendq/sendq.h"
+#include "thread_profile/thread_profile.h"
+#include "stream/stream.h"
+#include "camera/pixfmt.h"
+#include "trace/trace.h"
+#include "eptz/eptz.h"
+#include "fovea/fovea.h"
+#include "presence/presence.h"
+#include "refresh/refresh.h"
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
@@ -10,14 +20,87 @@
 double eng2_deg = 90.0;
 double eng3_deg = 90.0;
 static int engine_fd = -1;  // 设备文件描述符
+static const engine_backend_t *engine_backend = &engine_backend_hw; // 当前后端
+static bool engine_ready = false;
+static engine_actuation_hook actuation_hook = NULL;
+static int servo_accepting = 1;  // 是否执行舵机指令，快速启动复位期间为0（跨线程，原子访问）
 
-// 初始化舵机设备
-int engine_init() {
+// 真实驱动后端：打开设备文件
+static int hw_open(void) {
     engine_fd = open(ENGINE_DEVICE, O_RDWR);
     if (engine_fd < 0) {
         perror("舵机设备初始化失败");
         return -1;
     }
+    return 0;
+}
+
+// 真实驱动后端：通过ioctl下发目标步数
+static int hw_step(int command, int steps) {
+    return ioctl(engine_fd, steps, command);
+}
+
+// 真实驱动后端：关闭设备文件
+static void hw_close(void) {
+    close(engine_fd);
+    engine_fd = -1;
+}
+
+const engine_backend_t engine_backend_hw = {
+    .name = "hw",
+    .open = hw_open,
+    .step = hw_step,
+    .close = hw_close,
+};
+
+// 按名称选择舵机后端
+int engine_select_backend(const char *name) {
+    if (engine_ready) {
+        fprintf(stderr, "舵机已初始化，无法切换后端\n");
+        return -1;
+    }
+    if (name && strcmp(name, engine_backend_hw.name) == 0) {
+        engine_backend = &engine_backend_hw;
+    } else if (name && strcmp(name, engine_backend_sim.name) == 0) {
+        engine_backend = &engine_backend_sim;
+    } else {
+        fprintf(stderr, "未知舵机后端: %s\n", name ? name : "(null)");
+        return -1;
+    }
+    return 0;
+}
+
+// 获取当前后端名称
+const char *engine_backend_name(void) {
+    return engine_backend->name;
+}
+
+// 设置舵机到位回调
+void engine_set_actuation_hook(engine_actuation_hook hook) {
+    actuation_hook = hook;
+}
+
+// 设置是否执行舵机指令
+void engine_set_ready(bool ready) {
+    __atomic_store_n(&servo_accepting, ready ? 1 : 0, __ATOMIC_RELEASE);
+}
+
+// 舵机指令（角度、复位）能否执行：复位期间直接丢弃，下一条角度指令会覆盖
+static bool servo_command_allowed(void) {
+    if (__atomic_load_n(&servo_accepting, __ATOMIC_ACQUIRE)) {
+        return true;
+    }
+    printf("舵机复位中，忽略舵机指令\n");
+    return false;
+}
+
+// 初始化舵机设备
+int engine_init() {
+    if (engine_backend->open() != 0) {
+        return -1;
+    }
+    engine_ready = true;
+    printf("舵机后端: %s\n", engine_backend->name);
     reset_engine();
     return 0;
 }
@@ -27,6 +110,90 @@ void print_engine_angle() {
     printf("当前角度 eng2=%.1f, eng3=%.1f\n", eng2_deg, eng3_deg);
 }
 
+// 处理录像回放命令
+static void handle_replay(cJSON *root) {
+    cJSON *frame_id_obj = cJSON_GetObjectItem(root, "frame_id");
+    cJSON *time_obj = cJSON_GetObjectItem(root, "time_ms");
+    cJSON *count_obj = cJSON_GetObjectItem(root, "count");
+    int count = (count_obj && cJSON_IsNumber(count_obj)) ? count_obj->valueint : 0;
+    int ret;
+
+    if (count < 0 || (time_obj && cJSON_IsNumber(time_obj) && time_obj->valuedouble < 0) ||
+        (frame_id_obj && cJSON_IsNumber(frame_id_obj) && frame_id_obj->valuedouble < 0)) {
+        printf("录像回放参数无效: count、frame_id、time_ms 不能为负数\n");
+        return;
+    }
+    if (time_obj && cJSON_IsNumber(time_obj)) {
+        ret = recorder_replay_start(RECORDER_SEEK_TIME, (uint64_t)time_obj->valuedouble, count);
+    } else if (frame_id_obj && cJSON_IsNumber(frame_id_obj)) {
+        ret = recorder_replay_start(RECORDER_SEEK_FRAME_ID, (uint64_t)frame_id_obj->valuedouble, count);
+    } else {
+        // 未指定起点时从最旧的录像帧开始（包括之前运行录下的帧）
+        ret = recorder_replay_start(RECORDER_SEEK_TIME, 0, count);
+    }
+    if (ret != 0) {
+        printf("录像回放启动失败: %d\n", ret);
+    }
+}
+
+// 读取可选的整数字段
+static void get_int_field(cJSON *root, const char *name, int *value) {
+    cJSON *obj = cJSON_GetObjectItem(root, name);
+    if (obj && cJSON_IsNumber(obj)) {
+        *value = obj->valueint;
+    }
+}
+
+// 处理视频流重新配置命令：未给出的字段保持当前值，由采集线程在下一帧前应用
+static void handle_stream_config(cJSON *root) {
+    stream_config_t config;
+    cJSON *format_obj = cJSON_GetObjectItem(root, "format");
+    cJSON *dither_obj = cJSON_GetObjectItem(root, "dither");
+
+    stream_get_current(&config);
+    get_int_field(root, "width", &config.width);
+    get_int_field(root, "height", &config.height);
+    get_int_field(root, "capture_width", &config.capture_width);
+    get_int_field(root, "capture_height", &config.capture_height);
+    get_int_field(root, "crop_width", &config.crop_width);
+    get_int_field(root, "crop_height", &config.crop_height);
+    get_int_field(root, "roi_width", &config.roi_width);
+    get_int_field(root, "roi_height", &config.roi_height);
+    get_int_field(root, "fps", &config.fps);
+    get_int_field(root, "qos", &config.qos);
+    if (format_obj && cJSON_IsString(format_obj)) {
+        config.pixel_format = pixfmt_from_name(format_obj->valuestring);
+    }
+    if (dither_obj && (cJSON_IsBool(dither_obj) || cJSON_IsNumber(dither_obj))) {
+        config.dither = cJSON_IsTrue(dither_obj) || (cJSON_IsNumber(dither_obj) && dither_obj->valueint != 0);
+    }
+    if (stream_request(&config) != 0) {
+        printf("视频流配置命令无效，已忽略\n");
+    }
+}
+
+// 处理注视点命令：更新注视区域编码的中心位置
+static void handle_gaze(cJSON *root) {
+    cJSON *x_obj = cJSON_GetObjectItem(root, "x");
+    cJSON *y_obj = cJSON_GetObjectItem(root, "y");
+
+    if (!x_obj || !cJSON_IsNumber(x_obj) || !y_obj || !cJSON_IsNumber(y_obj)) {
+        printf("注视点命令缺少 x/y，已忽略\n");
+        return;
+    }
+    fovea_set_gaze(x_obj->valuedouble, y_obj->valuedouble);
+}
+
+// 处理刷新请求：接收端按 frame_id 发现缺口后发送，from/to 为缺失范围（可省略）
+static void handle_refresh(cJSON *root) {
+    cJSON *from_obj = cJSON_GetObjectItem(root, "from");
+    cJSON *to_obj = cJSON_GetObjectItem(root, "to");
+    bool has_range = from_obj && cJSON_IsNumber(from_obj) && to_obj && cJSON_IsNumber(to_obj);
+
+    refresh_request(has_range, has_range ? (uint32_t)from_obj->valuedouble : 0,
+                    has_range ? (uint32_t)to_obj->valuedouble : 0);
+}
+
 // 解析 JSON 数据并控制舵机
 void parse_json_and_control(const char *json_data) {
     if (!json_data) {
@@ -34,7 +201,9 @@ void parse_json_and_control(const char *json_data) {
         return;
     }
 
+    TRACE_BEGIN("json_parse");
     cJSON *root = cJSON_Parse(json_data);
+    TRACE_END("json_parse");
     if (!root) {
         printf("JSON 解析失败\n");
         return;
@@ -52,29 +221,89 @@ void parse_json_and_control(const char *json_data) {
      * {
      *   "cmd_type": "reset"
      * }
+     *
+     * 或者（回放本地录像，frame_id 与 time_ms 二选一，count 为0表示回放到最新帧）
+     * {
+     *   "cmd_type": "replay",
+     *   "frame_id": 1200,
+     *   "time_ms": 1700000000000,
+     *   "count": 100
+     * }
+     *
+     * 或者（运行中修改视频流参数，字段均可省略，省略的保持当前值）
+     * {
+     *   "cmd_type": "stream_config",
+     *   "width": 160,
+     *   "height": 120,
+     *   "capture_width": 640,
+     *   "capture_height": 480,
+     *   "crop_width": 360,
+     *   "crop_height": 360,
+     *   "roi_width": 96,
+     *   "roi_height": 96,
+     *   "fps": 15,
+     *   "qos": 0,
+     *   "format": "gray4",
+     *   "dither": true
+     * }
+     *
+     * 或者（注视点，输出画面归一化坐标 -1~1，0为中心；注视区域编码时全分辨率区域随之移动）
+     * {
+     *   "cmd_type": "gaze",
+     *   "x": 0.2,
+     *   "y": -0.1
+     * }
+     *
+     * 或者（刷新请求：接收端按 frame_id 发现缺口时发送，from/to 为缺失的帧ID范围，可省略）
+     * {
+     *   "cmd_type": "refresh",
+     *   "from": 1200,
+     *   "to": 1203
+     * }
      */
 
     cJSON *cmd_type_obj = cJSON_GetObjectItem(root, "cmd_type");
     if (cmd_type_obj && cJSON_IsString(cmd_type_obj)) {
         const char *cmd_type = cmd_type_obj->valuestring;
         if (strcmp(cmd_type, "angle_control") == 0) {
-            handle_angle_control(json_data); // 直接传递原始数据，内部也要用cJSON
+            if (servo_command_allowed()) {
+                handle_angle_control(json_data); // 直接传递原始数据，内部也要用cJSON
+            }
         } else if (strcmp(cmd_type, "reset") == 0) {
-            reset_engine();
+            if (servo_command_allowed()) {
+                reset_engine();
+            }
         } else if (strcmp(cmd_type, "status") == 0) {
             printf("当前舵机状态: Engine2=%.2f度, Engine3=%.2f度\n", eng2_deg, eng3_deg);
+            sendq_print_stats();
+            stream_print_status();
+            presence_print_status();
+            refresh_print_status();
+            thread_profile_print();
+        } else if (strcmp(cmd_type, "replay") == 0) {
+            handle_replay(root);
+        } else if (strcmp(cmd_type, "stream_config") == 0) {
+            handle_stream_config(root);
+        } else if (strcmp(cmd_type, "gaze") == 0) {
+            handle_gaze(root);
+        } else if (strcmp(cmd_type, "refresh") == 0) {
+            handle_refresh(root);
         } else {
             printf("未知命令类型: %s\n", cmd_type);
         }
     } else {
         // 向后兼容：如果没有命令类型，则按照旧格式处理
-        handle_angle_control(json_data);
+        if (servo_command_allowed()) {
+            handle_angle_control(json_data);
+        }
     }
     cJSON_Delete(root);
 }
 
 void handle_angle_control(const char *json_data) {
+    TRACE_BEGIN("json_parse");
     cJSON *root = cJSON_Parse(json_data);
+    TRACE_END("json_parse");
     if (!root) {
         printf("JSON 解析失败: 非法JSON\n");
         return;
@@ -121,27 +350,36 @@ void reset_engine() {
 
 // 控制舵机核心逻辑
 void control_engine(int command, double *angle, double new_angle) {
-    if (engine_fd < 0) {
+    if (!engine_ready) {
         printf("舵机设备未初始化，无法控制舵机。\n");
         return;
     }
     int steps = (int)round(new_angle / DEG_UNIT);  // 使用更精确的round
     if (steps != 0) {
-        // 构造ioctl参数
-        if (ioctl(engine_fd, steps, command) < 0) {  // 使用新命令
+        // 由当前后端下发目标步数
+        TRACE_BEGIN("control_engine");
+        int ret = engine_backend->step(command, steps);
+        TRACE_END("control_engine");
+        if (ret < 0) {
             perror("舵机控制失败");
         } else {
+            // 到位回调紧跟舵机写入，测得的延迟不含后续日志输出
+            if (actuation_hook) {
+                actuation_hook(command, new_angle);
+            }
             *angle = new_angle;  // 更新角度
+            // 电子云台立即把画面移到目标角度，舵机到位后窗口回到中心
+            eptz_command(command == Engine2 ? EPTZ_AXIS_TILT : EPTZ_AXIS_PAN, new_angle);
             printf("舵机 %d 已调整到 %.1f 度 \n", command, *angle);
         }
     }
 }
 
 void engine_close() {
-    if (engine_fd >= 0) {
+    if (engine_ready) {
         reset_engine();
-        close(engine_fd);
-        engine_fd = -1;
+        engine_backend->close();
+        engine_ready = false;
         printf("舵机设备已关闭\n");
     }
 }
\ No newline at end of file
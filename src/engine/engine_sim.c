@@ -0,0 +1,69 @@
+#include "engine/engine.h"
+#include <unistd.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+// 模拟舵机状态：记录每个舵机当前所在步数
+static int sim_position[2] = {0, 0};
+static unsigned long sim_commands = 0;
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 舵机编号转数组下标
+static int sim_index(int command) {
+    return (command == Engine3) ? 1 : 0;
+}
+
+// 模拟后端：打开设备，无需硬件
+static int sim_open(void) {
+    pthread_mutex_lock(&sim_lock);
+    sim_position[0] = 0;
+    sim_position[1] = 0;
+    sim_commands = 0;
+    pthread_mutex_unlock(&sim_lock);
+    printf("[SIM] 模拟舵机已启动: 每步 %d us, 最大转速 %.0f 度/秒, ioctl延迟 %d us\n",
+           ENGINE_SIM_STEP_US, ENGINE_SIM_SPEED_DPS, ENGINE_SIM_IOCTL_US);
+    return 0;
+}
+
+/**
+ * 模拟后端：转到目标步数
+ * 耗时 = ioctl延迟 + max(步数 x 每步耗时, 转角 / 最大转速)，与真实驱动一样阻塞到位
+ */
+static int sim_step(int command, int steps) {
+    int idx = sim_index(command);
+    int delta;
+    long travel_us, speed_us;
+
+    pthread_mutex_lock(&sim_lock);
+    delta = abs(steps - sim_position[idx]);
+    sim_commands++;
+    pthread_mutex_unlock(&sim_lock);
+
+    travel_us = (long)delta * ENGINE_SIM_STEP_US;
+    speed_us = (long)(delta * DEG_UNIT / ENGINE_SIM_SPEED_DPS * 1000000.0);
+    if (speed_us > travel_us) {
+        travel_us = speed_us;
+    }
+
+    usleep(ENGINE_SIM_IOCTL_US + travel_us);
+
+    pthread_mutex_lock(&sim_lock);
+    printf("[SIM] 舵机 %d: %d -> %d 步 (%d 步), 耗时 %ld us\n",
+           command, sim_position[idx], steps, delta, ENGINE_SIM_IOCTL_US + travel_us);
+    sim_position[idx] = steps;
+    pthread_mutex_unlock(&sim_lock);
+    return 0;
+}
+
+// 模拟后端：关闭设备
+static void sim_close(void) {
+    printf("[SIM] 模拟舵机已关闭，共执行 %lu 条指令\n", sim_commands);
+}
+
+const engine_backend_t engine_backend_sim = {
+    .name = "sim",
+    .open = sim_open,
+    .step = sim_step,
+    .close = sim_close,
+};
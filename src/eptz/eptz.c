@@ -0,0 +1,79 @@
+#include "eptz/eptz.h"
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+// 单轴状态：从 start 角度于 start_us 时刻开始匀速转向 target
+typedef struct {
+    bool known;          // 是否收到过目标角度
+    double start;        // 本次转动开始时的机械角度（估算）
+    double target;       // 目标角度
+    uint64_t start_us;   // 本次转动开始时刻
+} eptz_axis_state_t;
+
+static const double px_per_deg[EPTZ_AXIS_COUNT] = { EPTZ_PX_PER_DEG_PAN, EPTZ_PX_PER_DEG_TILT };
+static eptz_axis_state_t axes[EPTZ_AXIS_COUNT];
+static bool eptz_on = false;
+static pthread_mutex_t eptz_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// 估算当前机械角度
+static double mech_angle(const eptz_axis_state_t *axis, uint64_t now) {
+    double travel = EPTZ_SLEW_DEG_S * (double)(now - axis->start_us) / 1000000.0;
+    double remaining = axis->target - axis->start;
+    if (fabs(remaining) <= travel) {
+        return axis->target;
+    }
+    return axis->start + (remaining > 0 ? travel : -travel);
+}
+
+void eptz_set_enabled(bool enabled) {
+    pthread_mutex_lock(&eptz_lock);
+    eptz_on = enabled;
+    pthread_mutex_unlock(&eptz_lock);
+    if (enabled) {
+        printf("电子云台已启用（%.1f/%.1f 像素/度，电机 %.0f 度/秒）\n",
+               (double)EPTZ_PX_PER_DEG_PAN, (double)EPTZ_PX_PER_DEG_TILT, (double)EPTZ_SLEW_DEG_S);
+    }
+}
+
+// 舵机已接受新的目标角度
+void eptz_command(eptz_axis_t axis, double angle) {
+    uint64_t now = now_us();
+    eptz_axis_state_t *state;
+
+    if (axis < 0 || axis >= EPTZ_AXIS_COUNT) {
+        return;
+    }
+    pthread_mutex_lock(&eptz_lock);
+    state = &axes[axis];
+    // 首个目标角度视为舵机已在该位置
+    state->start = state->known ? mech_angle(state, now) : angle;
+    state->target = angle;
+    state->start_us = now;
+    state->known = true;
+    pthread_mutex_unlock(&eptz_lock);
+}
+
+// 当前裁剪窗口偏移
+void eptz_get_offset(int *dx, int *dy) {
+    uint64_t now = now_us();
+    double offset[EPTZ_AXIS_COUNT] = { 0, 0 };
+
+    pthread_mutex_lock(&eptz_lock);
+    for (int i = 0; eptz_on && i < EPTZ_AXIS_COUNT; i++) {
+        if (axes[i].known) {
+            offset[i] = (axes[i].target - mech_angle(&axes[i], now)) * px_per_deg[i];
+        }
+    }
+    pthread_mutex_unlock(&eptz_lock);
+
+    *dx = (int)lround(offset[EPTZ_AXIS_PAN]);
+    *dy = (int)lround(offset[EPTZ_AXIS_TILT]);
+}
@@ -0,0 +1,49 @@
+#include "fovea/fovea.h"
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+static double gaze_x = 0, gaze_y = 0;
+static uint64_t gaze_us = 0;     // 最近一次更新时刻，0为从未收到
+static pthread_mutex_t gaze_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static double clamp_unit(double v) {
+    return v < -1.0 ? -1.0 : (v > 1.0 ? 1.0 : v);
+}
+
+// 更新注视点
+void fovea_set_gaze(double x, double y) {
+    pthread_mutex_lock(&gaze_lock);
+    gaze_x = clamp_unit(x);
+    gaze_y = clamp_unit(y);
+    gaze_us = now_us();
+    pthread_mutex_unlock(&gaze_lock);
+}
+
+// 按注视点计算注视区域左上角
+void fovea_roi_origin(int width, int height, int roi_w, int roi_h, int *x, int *y) {
+    double gx = 0, gy = 0;
+    uint64_t now = now_us();
+
+    pthread_mutex_lock(&gaze_lock);
+    if (gaze_us != 0 && now - gaze_us <= (uint64_t)FOVEA_GAZE_TIMEOUT_MS * 1000) {
+        gx = gaze_x;
+        gy = gaze_y;
+    }
+    pthread_mutex_unlock(&gaze_lock);
+
+    // 注视点换算为像素后减去半个区域，再限制在图像内
+    int left = (int)lround((gx + 1.0) * 0.5 * width) - roi_w / 2;
+    int top = (int)lround((gy + 1.0) * 0.5 * height) - roi_h / 2;
+    left = left < 0 ? 0 : (left > width - roi_w ? width - roi_w : left);
+    top = top < 0 ? 0 : (top > height - roi_h ? height - roi_h : top);
+    *x = left & ~1;
+    *y = top & ~1;
+}
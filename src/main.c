@@ -5,36 +5,269 @@
 #include <time.h>
 #include <signal.h>
 #include <string.h>
+#include <getopt.h>
 #include "config/config.h"
 #include "camera/camera_test.h"
+#include "camera/scaler.h"
+#include "camera/pixfmt.h"
 #include "engine/engine.h"
 #include "mqtt/mqtt.h"
+#include "recorder/recorder.h"
+#include "sendq/sendq.h"
+#include "bench/bench.h"
+#include "reactor/reactor.h"
+#include "thread_profile/thread_profile.h"
+#include "stream/stream.h"
+#include "shmring/shmring.h"
+#include "trace/trace.h"
+#include "eptz/eptz.h"
+#include "presence/presence.h"
+#include "refresh/refresh.h"
 
 // 全局上下文
 static mqtt_ctx g_mqtt_ctx;
 volatile static int g_running = 1;
 static camera_config_t g_camera_config;
+static shmring_writer_t g_shmring = { .fd = -1 }; // 本地进程共享内存帧环
 static uint32_t g_frame_id = 0; // 帧ID计数器
+static mqtt_ctx g_control_ctx = { .notify_fd = -1 }; // 独立控制连接（启用时）
+static reactor_ctx g_reactor = { .epoll_fd = -1, .wakeup_fd = -1 }; // 监听线程的事件循环
+
+// 一条MQTT连接及其重连定时器（timerfd）
+typedef struct {
+    mqtt_ctx* ctx;
+    int timer_fd;
+} mqtt_link_t;
+static mqtt_link_t g_links[2] = { { NULL, -1 }, { NULL, -1 } };
+static int g_link_count = 0;
+
+// 启动各阶段完成时刻（相对进程启动的微秒数，-1为未完成），首帧发布时一并报告
+typedef struct {
+    uint64_t start_us;
+    int64_t servo_us;
+    int64_t camera_us;
+    int64_t mqtt_us;
+} startup_timing_t;
+static startup_timing_t g_startup = { 0, -1, -1, -1 };
+
+// 快速启动：舵机在后台线程中初始化，复位完成前不执行舵机指令
+static pthread_t g_servo_tid;
+static bool g_servo_pending = false; // 后台舵机初始化线程尚未回收
+static int g_servo_ret = 0;          // engine_init 的结果
 
 // 信号处理函数
 void sig_handler(int sig) {
+    // SIGUSR1：导出追踪事件，由监听线程写文件
+    if (sig == SIGUSR1) {
+        trace_request_dump();
+        return;
+    }
     printf("\n收到终止信号，清理资源...\n");
     g_running = 0;
+    reactor_stop(&g_reactor);
 }
 
-// 视频发布线程函数（主线程）
-void* video_publish_thread(void* arg) {
+// 按当前摄像头配置生成本帧布局（调色板位于帧数据开头，发布时再填写指针）
+static frame_layout_t current_layout(void) {
+    int format = g_camera_config.pixel_format;
+    frame_layout_t layout = {
+        .width = (uint16_t)g_camera_config.width,
+        .height = (uint16_t)g_camera_config.height,
+        .pixel_format = (uint8_t)format,
+        .flags = (g_camera_config.dither && format != PIXEL_FORMAT_RGB565 &&
+                  format != PIXEL_FORMAT_GRAY8) ? FRAME_FLAG_DITHERED : 0,
+        .palette = NULL,
+        .palette_len = (uint16_t)pixfmt_palette_bytes(format),
+    };
+    camera_roi_t roi;
+
+    // 注视区域编码：区域位置随注视点逐帧变化，须在 camera_get_frame 之后取得
+    if (camera_get_roi(&roi)) {
+        layout.flags |= FRAME_FLAG_FOVEATED;
+        layout.roi.roi_x = (uint16_t)roi.x;
+        layout.roi.roi_y = (uint16_t)roi.y;
+        layout.roi.roi_width = (uint16_t)roi.width;
+        layout.roi.roi_height = (uint16_t)roi.height;
+        layout.roi.periph_width = (uint16_t)roi.periph_width;
+        layout.roi.periph_height = (uint16_t)roi.periph_height;
+    }
+    return layout;
+}
+
+// 发布一帧图像（整帧或分片），实时推流与录像回放共用，保证两者帧头格式一致
+static int publish_frame(const char* topic, const frame_header_t* header, const frame_layout_t* frame_layout,
+                         const unsigned char* frame_data, long frame_size, int qos) {
+    int ret;
+
+    // 分片模式或非默认布局：使用携带尺寸与像素格式的扩展帧头；默认 RGB565 整帧保持原有帧头
+    if (CHUNK_ENABLE || (frame_layout->flags & FRAME_FLAG_FOVEATED) ||
+        frame_layout->pixel_format != PIXEL_FORMAT_RGB565 ||
+        frame_layout->width != FRAME_WIDTH || frame_layout->height != FRAME_HEIGHT) {
+        size_t palette_len = frame_layout->palette_len;
+        frame_layout_t layout = *frame_layout;
+        layout.palette = palette_len ? frame_data : NULL;
+        // 未启用分片时整帧作为一个分片发送
+        ret = mqtt_publish_chunked(&g_mqtt_ctx, topic, header->frame_id,
+                                   frame_data + palette_len, frame_size - palette_len,
+                                   &layout, CHUNK_ENABLE ? CHUNK_SIZE : (size_t)frame_size, qos);
+        if (ret != 0) {
+            fprintf(stderr, "图像分片发布失败\n");
+        } else {
+            printf("成功分片发布图像数据，帧ID: %u, 大小: %ld 字节\n",
+                   header->frame_id, frame_size);
+        }
+        return ret;
+    }
+
+    // 分配内存用于存储帧头+帧数据
+    size_t total_size = sizeof(frame_header_t) + frame_size;
+    unsigned char* mqtt_payload = (unsigned char*)malloc(total_size);
+    if (!mqtt_payload) {
+        fprintf(stderr, "内存分配失败\n");
+        return -1;
+    }
+
+    // 复制帧头和帧数据到完整数据包
+    memcpy(mqtt_payload, header, sizeof(frame_header_t));
+    memcpy(mqtt_payload + sizeof(frame_header_t), frame_data, frame_size);
+
+    // 发布到MQTT
+    ret = mqtt_publish_typed(&g_mqtt_ctx, topic, mqtt_payload, total_size, qos,
+                             MQTT5_CONTENT_TYPE_FRAME);
+    if (ret != 0) {
+        fprintf(stderr, "图像发布失败\n");
+    } else {
+        printf("成功发布图像数据，帧ID: %u, 大小: %ld 字节\n", 
+               header->frame_id, frame_size);
+    }
+
+    // 释放完整数据包内存
+    free(mqtt_payload);
+    return ret;
+}
+
+// 录像回放：按录制时的布局发布到回放主题
+static int publish_replay_frame(const frame_header_t* header, const frame_layout_t* layout,
+                                const unsigned char* data, long size) {
+    return publish_frame(TOPIC_REPLAY, header, layout, data, size, g_mqtt_ctx.pub_qos);
+}
+
+// 舵机指令处理入口：在 Paho 回调线程中执行，首次调用时为该线程应用控制线程配置
+static void control_handler(const char* payload) {
+    static __thread bool profile_applied = false;
+
+    if (THREAD_PROFILE_ENABLE && !profile_applied) {
+        thread_profile_apply(THREAD_ROLE_CONTROL);
+        profile_applied = true;
+    }
+    // 快速启动时MQTT可能先于舵机复位就绪，复位期间由引擎丢弃舵机指令，其他指令照常处理
+    parse_json_and_control(payload);
+}
+
+// 距进程启动的微秒数
+static int64_t startup_elapsed_us(void) {
+    return (int64_t)(sendq_now_us() - g_startup.start_us);
+}
+
+// 首帧发布成功：报告启动到首帧的耗时及各阶段完成时刻
+static void report_first_frame(void) {
+    int64_t servo_us = __atomic_load_n(&g_startup.servo_us, __ATOMIC_ACQUIRE);
+    char servo[32];
+
+    if (servo_us < 0) {
+        snprintf(servo, sizeof(servo), "复位中");
+    } else {
+        snprintf(servo, sizeof(servo), "%lld ms", (long long)(servo_us / 1000));
+    }
+    printf("首帧已发布: 启动后 %lld ms（摄像头 %lld ms，MQTT %lld ms，舵机 %s）\n",
+           (long long)(startup_elapsed_us() / 1000), (long long)(g_startup.camera_us / 1000),
+           (long long)(g_startup.mqtt_us / 1000), servo);
+}
+
+// 在采集线程中应用 stream_config 命令：只重建受影响的阶段，MQTT连接保持不变
+static void apply_stream_config(const stream_config_t* config, reactor_ticker_t* ticker) {
+    uint64_t start = sendq_now_us();
+    camera_config_t camera_config = g_camera_config;
+    int ret;
+
+    camera_config.width = config->width;
+    camera_config.height = config->height;
+    camera_config.capture_width = config->capture_width;
+    camera_config.capture_height = config->capture_height;
+    camera_config.crop_width = config->crop_width;
+    camera_config.crop_height = config->crop_height;
+    camera_config.roi_width = config->roi_width;
+    camera_config.roi_height = config->roi_height;
+    camera_config.pixel_format = config->pixel_format;
+    camera_config.dither = config->dither;
+    camera_config.fps = config->fps;
+
+    ret = camera_reconfigure(&camera_config);
+    if (ret == 0) {
+        // 帧率只影响采集定时器，QoS 只影响后续发布
+        if (config->fps != g_camera_config.fps) {
+            reactor_ticker_set_period(ticker, 1000000 / config->fps);
+        }
+        g_mqtt_ctx.pub_qos = config->qos;
+        g_camera_config = camera_config;
+        stream_set_current(config);
+    }
+    stream_report(config, sendq_now_us() - start, ret);
+}
+
+// 无观看者：暂停解码与发布直到有观看者持有租约，恢复后的首帧立即采集
+static void suspend_until_viewer(reactor_ticker_t* ticker) {
+    presence_mark_suspended();
+    if (PRESENCE_CLOSE_CAMERA) {
+        camera_deinit();
+    }
+    
+    while (g_running && !presence_wait(500)) {
+    }
+    
+    // 关闭过摄像头时重新打开，失败则每秒重试
+    while (PRESENCE_CLOSE_CAMERA && g_running && camera_init(&g_camera_config) != 0) {
+        fprintf(stderr, "恢复推流时摄像头打开失败，1秒后重试\n");
+        sleep(1);
+    }
+    
+    // 帧周期网格从恢复时刻重新开始，暂停期间的周期不计为错过
+    reactor_ticker_set_period(ticker, ticker->period_us);
+}
+
+// 视频采集线程函数：按目标帧率采集，帧交给发送队列后立即采集下一帧
+void* video_capture_thread(void* arg) {
     (void)arg;
+    if (THREAD_PROFILE_ENABLE) {
+        thread_profile_apply(THREAD_ROLE_CAPTURE);
+    }
     
-    // 帧率控制变量
-    struct timespec start_time, end_time;
-    long elapsed_us, sleep_us;
-    const long target_frame_time_us = 1000000 / TARGET_FPS; // 根据目标帧率计算帧间隔
+    // 帧率控制：timerfd 绝对截止时间，帧间隔不随采集耗时漂移
+    reactor_ticker_t ticker;
+    const long target_frame_time_us = 1000000 / g_camera_config.fps; // 根据目标帧率计算帧间隔
     int consecutive_failures = 0;
     const int max_failures = MAX_FAILURES; // 最大连续失败次数
     
+    if (reactor_ticker_init(&ticker, target_frame_time_us) != 0) {
+        fprintf(stderr, "帧率定时器初始化失败\n");
+        sendq_shutdown();
+        return NULL;
+    }
+    
     while(g_running) {
-        clock_gettime(CLOCK_MONOTONIC, &start_time);
+        // 应用运行中提交的视频流参数（在两帧之间进行）
+        stream_config_t stream_config;
+        if (stream_take_pending(&stream_config)) {
+            apply_stream_config(&stream_config, &ticker);
+        }
+        
+        // 按需推流：没有观看者时不解码也不发布
+        if (!presence_active()) {
+            suspend_until_viewer(&ticker);
+            continue;
+        }
+        
+        uint64_t capture_us = sendq_now_us(); // 采集时刻，用于计算发送截止时间
         
         unsigned char* frame_data = NULL;
         long frame_size = 0;
@@ -44,37 +277,42 @@ void* video_publish_thread(void* arg) {
         if(ret == 0 && frame_data != NULL && frame_size > 0) {
             consecutive_failures = 0; // 重置失败计数
             
-            // 创建带帧头的完整数据包
+            // 创建帧头
             frame_header_t header;
             header.frame_id = g_frame_id++;
             header.frame_len = frame_size;
             
-            // 分配内存用于存储帧头+帧数据
-            size_t total_size = sizeof(frame_header_t) + frame_size;
-            unsigned char* mqtt_payload = (unsigned char*)malloc(total_size);
-            if (mqtt_payload) {
-                // 复制帧头和帧数据到完整数据包
-                memcpy(mqtt_payload, &header, sizeof(frame_header_t));
-                memcpy(mqtt_payload + sizeof(frame_header_t), frame_data, frame_size);
-                
-                // 发布到MQTT
-                if(mqtt_publish(&g_mqtt_ctx, TOPIC_PUB, mqtt_payload, total_size) != 0) {
-                    fprintf(stderr, "图像发布失败\n");
-                    consecutive_failures++;
-                } else {
-                    printf("成功发布图像数据，帧ID: %u, 大小: %ld 字节\n", 
-                           header.frame_id, frame_size);
-                }
-                
-                // 释放完整数据包内存
-                free(mqtt_payload);
-            } else {
-                fprintf(stderr, "内存分配失败\n");
-                consecutive_failures++;
+            // 写入本地环形录像（仅入队，不等待文件系统），布局随帧保存，回放时按原格式发布
+            frame_layout_t layout = current_layout();
+            if (RECORDER_ENABLE) {
+                recorder_append(&header, &layout, frame_data);
+            }
+            
+            // 写入共享内存帧环供本地进程读取（覆盖最旧的帧，不等待读者）
+            if (SHMRING_ENABLE) {
+                shmring_frame_t meta = {
+                    .frame_id = header.frame_id,
+                    .capture_us = capture_us,
+                    .width = layout.width,
+                    .height = layout.height,
+                    .pixel_format = layout.pixel_format,
+                    .flags = layout.flags,
+                    .palette_len = layout.palette_len,
+                    .roi_x = layout.roi.roi_x,
+                    .roi_y = layout.roi.roi_y,
+                    .roi_width = layout.roi.roi_width,
+                    .roi_height = layout.roi.roi_height,
+                    .periph_width = layout.roi.periph_width,
+                    .periph_height = layout.roi.periph_height,
+                };
+                shmring_write(&g_shmring, &meta, frame_data, (size_t)frame_size);
             }
             
-            // 释放帧内存
-            free(frame_data);
+            // 交给发布线程，帧内存由发送队列接管
+            sendq_push(&header, &layout, frame_data, frame_size, capture_us);
+            if (presence_enabled()) {
+                presence_mark_resumed();
+            }
         } else {
             fprintf(stderr, "获取图像数据失败: %d\n", ret);
             consecutive_failures++;
@@ -87,28 +325,178 @@ void* video_publish_thread(void* arg) {
             }
         }
         
-        // 精确帧率控制
-        clock_gettime(CLOCK_MONOTONIC, &end_time);
-        elapsed_us = (end_time.tv_sec - start_time.tv_sec) * 1000000 + 
-                     (end_time.tv_nsec - start_time.tv_nsec) / 1000;
+        // 睡眠到下一个帧截止时间；采集超时错过的周期直接跳过，不做追赶
+        if (reactor_ticker_wait(&ticker) > 1 && ticker.missed % 10 == 1) {
+            fprintf(stderr, "采集耗时超过帧间隔，累计错过 %llu 个周期\n",
+                    (unsigned long long)ticker.missed);
+        }
+    }
+    reactor_ticker_close(&ticker);
+
+    // 通知发布线程退出
+    sendq_shutdown();
+    return NULL;
+}
+
+// 视频发布线程函数：从发送队列取帧发布，过旧的帧在队列中被丢弃
+void* video_publish_thread(void* arg) {
+    (void)arg;
+    sendq_item_t item;
+    bool first_published = false;
+    if (THREAD_PROFILE_ENABLE) {
+        thread_profile_apply(THREAD_ROLE_PUBLISH);
+    }
+    
+    while(sendq_pop(&item) == 0) {
+        // 断线期间直接丢弃：采集和录像照常进行，重连后从最新帧恢复推流
+        if (!g_mqtt_ctx.connected) {
+            sendq_report_drop(SENDQ_DROP_OFFLINE);
+            free(item.data);
+            continue;
+        }
+        // 接收端请求刷新时本帧以 REFRESH_QOS 发送，保证其得到一幅完整画面
+        int qos = g_mqtt_ctx.pub_qos;
+        if (refresh_take() && qos < REFRESH_QOS) {
+            qos = REFRESH_QOS;
+        }
+        uint64_t send_start = sendq_now_us();
+        int ret = publish_frame(TOPIC_PUB, &item.header, &item.layout, item.data, item.size, qos);
+        sendq_report(&item, sendq_now_us() - send_start, ret == 0);
+        if (ret == 0) {
+            refresh_note_published(item.header.frame_id);
+            if (!first_published) {
+                report_first_frame();
+                first_published = true;
+            }
+        }
+        free(item.data);
         
-        sleep_us = target_frame_time_us - elapsed_us;
-        if (sleep_us > 0) {
-            usleep(sleep_us);
+        // 每100帧打印一次发送队列统计
+        if (item.header.frame_id % 100 == 0) {
+            sendq_print_stats();
         }
     }
     return NULL;
 }
 
-// MQTT监听线程函数
+// MQTT连接状态变化通知或重连定时器到期：处理重连，按返回的间隔重新定时
+static void on_mqtt_event(int fd, uint32_t events, void* arg) {
+    mqtt_link_t* link = (mqtt_link_t*)arg;
+    (void)events;
+    reactor_drain(fd);
+    reactor_timer_arm_ms(link->timer_fd, mqtt_loop(link->ctx));
+}
+
+// 追踪导出请求（SIGUSR1）：在监听线程中写文件
+static void on_trace_event(int fd, uint32_t events, void* arg) {
+    (void)fd;
+    (void)events;
+    (void)arg;
+    trace_handle_notify();
+}
+
+// 初始化MQTT连接：视频连接始终存在，控制指令可走独立连接
+static int init_mqtt_links(const char* address, bool control_split, bool mqtt5) {
+    // 观看者心跳与控制指令走同一条连接
+    const char* presence_topic = presence_enabled() ? TOPIC_VIEWER : NULL;
+    mqtt_options_t video_opts = {
+        .client_id = DEFAULT_CLIENT_ID,
+        .sub_topic = control_split ? NULL : TOPIC_SUB,
+        .qos = DEFAULT_QOS,
+        .keepalive = MQTT_KEEPALIVE,
+        .presence_topic = control_split ? NULL : presence_topic,
+        .presence_handler = presence_handle,
+        .mqtt5 = mqtt5,
+        .message_expiry = MQTT5_MESSAGE_EXPIRY,
+    };
+    mqtt_options_t control_opts = {
+        .client_id = CONTROL_CLIENT_ID,
+        .sub_topic = TOPIC_SUB,
+        .qos = CONTROL_QOS,
+        .keepalive = CONTROL_KEEPALIVE,
+        .presence_topic = presence_topic,
+        .presence_handler = presence_handle,
+        .mqtt5 = mqtt5,
+    };
+
+    if (mqtt_init_opts(&g_mqtt_ctx, control_handler, address, &video_opts) != 0) {
+        return -1;
+    }
+    g_links[g_link_count++].ctx = &g_mqtt_ctx;
+
+    if (control_split) {
+        if (mqtt_init_opts(&g_control_ctx, control_handler, address, &control_opts) != 0) {
+            mqtt_disconnect(&g_mqtt_ctx);
+            g_link_count = 0;
+            return -1;
+        }
+        g_links[g_link_count++].ctx = &g_control_ctx;
+    }
+    return 0;
+}
+
+// 快速启动：后台初始化舵机（含复位扫动）
+static void* servo_init_thread(void* arg) {
+    (void)arg;
+    g_servo_ret = engine_init();
+    __atomic_store_n(&g_startup.servo_us, startup_elapsed_us(), __ATOMIC_RELEASE);
+    if (g_servo_ret == 0) {
+        engine_set_ready(true);
+    }
+    return NULL;
+}
+
+// 等待后台舵机初始化结束（未使用快速启动时立即返回），返回 engine_init 的结果
+static int wait_servo_init(void) {
+    if (g_servo_pending) {
+        pthread_join(g_servo_tid, NULL);
+        g_servo_pending = false;
+    }
+    return g_servo_ret;
+}
+
+// 关闭舵机：先等待后台复位结束，避免与复位同时操作设备
+static void close_engine(void) {
+    wait_servo_init();
+    engine_close();
+}
+
+// 快速启动：后台建立MQTT连接的参数与结果
+typedef struct {
+    const char* address;
+    bool control_split;
+    bool mqtt5;
+    int ret;
+} mqtt_init_job_t;
+
+static void* mqtt_init_thread(void* arg) {
+    mqtt_init_job_t* job = (mqtt_init_job_t*)arg;
+    job->ret = init_mqtt_links(job->address, job->control_split, job->mqtt5);
+    g_startup.mqtt_us = startup_elapsed_us();
+    return NULL;
+}
+
+// 断开所有MQTT连接
+static void close_mqtt_links(void) {
+    for (int i = 0; i < g_link_count; i++) {
+        mqtt_disconnect(g_links[i].ctx);
+        if (g_links[i].timer_fd >= 0) {
+            close(g_links[i].timer_fd);
+            g_links[i].timer_fd = -1;
+        }
+    }
+    g_link_count = 0;
+}
+
+// MQTT监听线程函数：事件循环只在断线通知、重连定时或退出时被唤醒
 void* mqtt_listen_thread(void* arg) {
     (void)arg;
-    
-    while(g_running) {
-        // 维持MQTT连接（非阻塞）
-        mqtt_loop(&g_mqtt_ctx);
-        usleep(10000); // 10ms检查间隔
+    if (THREAD_PROFILE_ENABLE) {
+        thread_profile_apply(THREAD_ROLE_LISTEN);
     }
+    
+    reactor_run(&g_reactor);
+    printf("监听线程退出，事件循环共唤醒 %llu 次\n", (unsigned long long)g_reactor.wakeups);
     return NULL;
 }
 
@@ -130,48 +518,349 @@ void* test_camera_data_publish(void* arg) {
     }
 }
 
-int main() {
+// 打印命令行用法
+static void print_usage(const char* prog) {
+    printf("用法: %s [选项]\n", prog);
+    printf("  --engine=hw|sim       舵机后端，默认 %s\n", ENGINE_BACKEND);
+    printf("  --broker=URI[,URI...] MQTT服务器地址列表，按顺序故障切换，默认 %s\n", BROKER_LIST);
+    printf("  --control=shared|split 控制指令与视频共用连接或使用独立连接，默认 %s\n",
+           CONTROL_SPLIT_ENABLE ? "split" : "shared");
+    printf("  --mqtt5=0|1           优先使用MQTT 5（主题别名、消息过期），服务器不支持时回退3.1.1，默认 %d\n",
+           MQTT5_ENABLE);
+    printf("  --bench-video         控制延迟基准测试时同时发送满带宽视频负载\n");
+    printf("  --pixel-format=FMT    输出像素格式 rgb565|rgb332|gray8|gray4|pal8，默认 %s\n", PIXEL_FORMAT);
+    printf("  --dither=0|1          降低位深时是否抖动，默认 %d\n", PIXEL_DITHER);
+    printf("  --grab=latest|all     只解码最新帧或按顺序解码每一帧，默认 %s\n",
+           GRAB_LATEST_ENABLE ? "latest" : "all");
+    printf("  --on-demand=0|1       仅在观看者通过 %s 持有租约时解码和推流，默认 %d\n",
+           TOPIC_VIEWER, PRESENCE_ENABLE);
+    printf("  --eptz=0|1            电子云台：裁取 %dx%d 窗口并随角度指令立即平移，默认 %d\n",
+           EPTZ_CROP_WIDTH, EPTZ_CROP_HEIGHT, EPTZ_ENABLE);
+    printf("  --fovea=0|1           注视区域编码：中心 %dx%d 全分辨率，外围缩小 %d 倍，默认 %d\n",
+           FOVEA_ROI_WIDTH, FOVEA_ROI_HEIGHT, FOVEA_PERIPH_SCALE, FOVEA_ENABLE);
+    printf("  --scale-workers=N     格式转换/缩放切片线程数，默认 %d\n", SCALE_WORKERS);
+    printf("  --fast-start=0|1      舵机复位、摄像头与MQTT并行初始化，摄像头不探测流信息，默认 %d\n",
+           FASTSTART_ENABLE);
+    printf("  --trace[=FILE]        记录事件追踪，退出或收到SIGUSR1时导出 Chrome trace JSON，默认 %s\n",
+           TRACE_PATH);
+    printf("  --bench-scale         测试1~%d个切片线程的缩放耗时\n", SCALER_MAX_WORKERS);
+    printf("  --bench-engine=FILE   回放指令记录文件，分别测量共用/独立连接下的舵机控制延迟\n"
+           "                        （默认使用sim后端和 %s）\n", BENCH_BROKER);
+    printf("  --bench-shutdown=MS   正常启动，MS 毫秒后向自身发送SIGINT，用于检查启动各阶段收到信号后能否退出\n");
+    printf("  --bench-mqtt5         测试MQTT 5主题别名、消息过期、内容类型及回退3.1.1，服务器默认 %s\n",
+           BENCH_BROKER);
+    printf("  -h, --help            显示帮助\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* engine_backend = NULL;
+    const char* broker = NULL;
+    const char* bench_engine_file = NULL;
+    int scale_workers = SCALE_WORKERS;
+    bool bench_scale = false;
+    bool bench_mqtt5 = false;
+    int bench_shutdown_ms = -1;
+    bool bench_video = false;
+    bool control_split = CONTROL_SPLIT_ENABLE;
+    bool mqtt5 = MQTT5_ENABLE;
+    int pixel_format = pixfmt_from_name(PIXEL_FORMAT);
+    bool dither = PIXEL_DITHER;
+    bool grab_latest = GRAB_LATEST_ENABLE;
+    const char* trace_file = NULL;
+    bool eptz = EPTZ_ENABLE;
+    bool fovea = FOVEA_ENABLE;
+    bool on_demand = PRESENCE_ENABLE;
+    bool fast_start = FASTSTART_ENABLE;
+    static const struct option long_options[] = {
+        {"engine",       required_argument, NULL, 'e'},
+        {"broker",       required_argument, NULL, 'b'},
+        {"bench-engine", required_argument, NULL, 'B'},
+        {"scale-workers", required_argument, NULL, 'w'},
+        {"bench-scale",  no_argument,       NULL, 'S'},
+        {"bench-video",  no_argument,       NULL, 'V'},
+        {"bench-mqtt5",  no_argument,       NULL, 'M'},
+        {"bench-shutdown", required_argument, NULL, 'X'},
+        {"control",      required_argument, NULL, 'c'},
+        {"mqtt5",        required_argument, NULL, '5'},
+        {"pixel-format", required_argument, NULL, 'p'},
+        {"dither",       required_argument, NULL, 'd'},
+        {"grab",         required_argument, NULL, 'g'},
+        {"trace",        optional_argument, NULL, 't'},
+        {"eptz",         required_argument, NULL, 'z'},
+        {"fovea",        required_argument, NULL, 'f'},
+        {"on-demand",    required_argument, NULL, 'o'},
+        {"fast-start",   required_argument, NULL, 'F'},
+        {"help",         no_argument,       NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+
+    g_startup.start_us = sendq_now_us();
+
+    // 解析命令行参数
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 'e': engine_backend = optarg; break;
+        case 'b': broker = optarg; break;
+        case 'B': bench_engine_file = optarg; break;
+        case 'w': scale_workers = atoi(optarg); break;
+        case 'S': bench_scale = true; break;
+        case 'V': bench_video = true; break;
+        case 'M': bench_mqtt5 = true; break;
+        case 'X': bench_shutdown_ms = atoi(optarg); break;
+        case 'p':
+            if ((pixel_format = pixfmt_from_name(optarg)) < 0) {
+                fprintf(stderr, "未知像素格式: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'd': dither = atoi(optarg) != 0; break;
+        case 'o': on_demand = atoi(optarg) != 0; break;
+        case '5': mqtt5 = atoi(optarg) != 0; break;
+        case 'z': eptz = atoi(optarg) != 0; break;
+        case 'f': fovea = atoi(optarg) != 0; break;
+        case 'F': fast_start = atoi(optarg) != 0; break;
+        case 't': trace_file = optarg ? optarg : TRACE_PATH; break;
+        case 'g':
+            if (strcmp(optarg, "latest") == 0) {
+                grab_latest = true;
+            } else if (strcmp(optarg, "all") == 0) {
+                grab_latest = false;
+            } else {
+                print_usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'c':
+            if (strcmp(optarg, "split") == 0) {
+                control_split = true;
+            } else if (strcmp(optarg, "shared") == 0) {
+                control_split = false;
+            } else {
+                print_usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'h': print_usage(argv[0]); return 0;
+        default:  print_usage(argv[0]); return 1;
+        }
+    }
+
+    // 缩放基准测试：不需要摄像头、舵机和MQTT
+    if (bench_scale) {
+        return bench_scale_run(SCALER_MAX_WORKERS, 200) == 0 ? 0 : 1;
+    }
+
+    // MQTT 5 功能测试：只需要MQTT服务器
+    if (bench_mqtt5) {
+        return bench_mqtt5_run(broker ? broker : BENCH_BROKER) == 0 ? 0 : 1;
+    }
+
+    // 选择舵机后端，基准测试默认使用模拟舵机
+    if (!engine_backend) {
+        engine_backend = bench_engine_file ? "sim" : ENGINE_BACKEND;
+    }
+    if (engine_select_backend(engine_backend) != 0) {
+        return 1;
+    }
+
+    // 基准测试模式：不启动摄像头和视频推流
+    if (bench_engine_file) {
+        return bench_engine_run(bench_engine_file, broker ? broker : BENCH_BROKER,
+                                bench_video) == 0 ? 0 : 1;
+    }
+
+    // 监听线程的事件循环须在注册信号处理前创建：初始化期间收到的终止信号
+    // 由 reactor_stop 记录在已建立的事件循环上，监听线程启动后立即退出
+    if (reactor_init(&g_reactor) != 0) {
+        fprintf(stderr, "事件循环初始化失败\n");
+        return 1;
+    }
+
     // 注册信号处理
     signal(SIGINT, sig_handler);
     signal(SIGTERM, sig_handler);
+    if (bench_shutdown_ms >= 0) {
+        bench_shutdown_arm(bench_shutdown_ms);
+    }
 
-    // 初始化舵机
-    if (engine_init() != 0) {
-        printf("舵机初始化失败，程序退出。\n");
-        return -1;
+    // 事件追踪（失败不影响运行）
+    if (trace_file && trace_init(trace_file) == 0) {
+        signal(SIGUSR1, sig_handler);
     }
 
-    // 初始化摄像头
+    // 线程放置配置（内存锁定需在创建线程前完成）
+    if (THREAD_PROFILE_ENABLE) {
+        thread_profile_init(THREAD_MLOCKALL);
+    }
+
+    // 摄像头参数
     g_camera_config.device = CAMERA_DEVICE;
-    g_camera_config.width = 240;
-    g_camera_config.height = 240;
+    g_camera_config.width = FRAME_WIDTH;
+    g_camera_config.height = FRAME_HEIGHT;
+    g_camera_config.capture_width = CAPTURE_WIDTH;
+    g_camera_config.capture_height = CAPTURE_HEIGHT;
+    g_camera_config.crop_width = eptz ? EPTZ_CROP_WIDTH : 0;
+    g_camera_config.crop_height = eptz ? EPTZ_CROP_HEIGHT : 0;
+    eptz_set_enabled(eptz);
+    g_camera_config.roi_width = fovea ? FOVEA_ROI_WIDTH : 0;
+    g_camera_config.roi_height = fovea ? FOVEA_ROI_HEIGHT : 0;
+    g_camera_config.roi_scale = FOVEA_PERIPH_SCALE;
     g_camera_config.fps = TARGET_FPS;
+    g_camera_config.capture_fps = CAPTURE_FPS;
+    g_camera_config.grab_latest = grab_latest;
+    g_camera_config.fast_start = fast_start;
+    g_camera_config.scale_workers = scale_workers;
+    g_camera_config.decode_threads = DECODE_THREADS;
+    g_camera_config.pixel_format = pixel_format < 0 ? PIXEL_FORMAT_RGB565 : pixel_format;
+    g_camera_config.dither = dither;
     g_camera_config.is_initialized = false;
     
+    // 登记初始视频流参数，供 stream_config 命令在此基础上修改（快速启动时MQTT可能先于摄像头就绪）
+    stream_config_t stream_config = {
+        .width = g_camera_config.width,
+        .height = g_camera_config.height,
+        .capture_width = g_camera_config.capture_width,
+        .capture_height = g_camera_config.capture_height,
+        .crop_width = g_camera_config.crop_width,
+        .crop_height = g_camera_config.crop_height,
+        .roi_width = g_camera_config.roi_width,
+        .roi_height = g_camera_config.roi_height,
+        .fps = g_camera_config.fps,
+        .qos = VIDEO_QOS,
+        .pixel_format = g_camera_config.pixel_format,
+        .dither = g_camera_config.dither,
+    };
+    stream_set_current(&stream_config);
+    
+    // 观看者租约需在订阅前初始化
+    presence_init(on_demand);
+    mqtt_init_job_t mqtt_job = {
+        .address = broker ? broker : BROKER_LIST,
+        .control_split = control_split,
+        .mqtt5 = mqtt5,
+    };
+    pthread_t mqtt_init_tid;
+    
+    if (fast_start) {
+        // 快速启动：舵机复位与MQTT连接在后台进行，与打开摄像头并行；舵机复位不阻塞首帧
+        engine_set_ready(false);
+        if (pthread_create(&g_servo_tid, NULL, servo_init_thread, NULL) != 0) {
+            fprintf(stderr, "舵机初始化线程创建失败\n");
+            return 1;
+        }
+        g_servo_pending = true;
+        if (pthread_create(&mqtt_init_tid, NULL, mqtt_init_thread, &mqtt_job) != 0) {
+            fprintf(stderr, "MQTT初始化线程创建失败\n");
+            close_engine();
+            return 1;
+        }
+    } else {
+        // 依次初始化：舵机复位完成后再打开摄像头、连接MQTT
+        if (engine_init() != 0) {
+            printf("舵机初始化失败，程序退出。\n");
+            return -1;
+        }
+        g_startup.servo_us = startup_elapsed_us();
+    }
+    
+    // 初始化摄像头
     int camera_ret = camera_init(&g_camera_config);
+    g_startup.camera_us = startup_elapsed_us();
     if (camera_ret != 0) {
         fprintf(stderr, "摄像头初始化失败，错误码: %d\n", camera_ret);
+        if (fast_start) {
+            pthread_join(mqtt_init_tid, NULL);
+            if (mqtt_job.ret == 0) {
+                close_mqtt_links();
+            }
+        }
+        close_engine();
         return 1;
     }
     printf("摄像头初始化成功\n");
-
+    
     // 初始化MQTT
-    int mqtt_ok = mqtt_init(&g_mqtt_ctx, parse_json_and_control);
-    if(mqtt_ok != 0) {
+    if (fast_start) {
+        pthread_join(mqtt_init_tid, NULL);
+    } else {
+        mqtt_job.ret = init_mqtt_links(mqtt_job.address, control_split, mqtt5);
+        g_startup.mqtt_us = startup_elapsed_us();
+    }
+    if (mqtt_job.ret != 0) {
         fprintf(stderr, "MQTT初始化失败\n");
         camera_deinit();
-        engine_close();
+        close_engine();
+        return 1;
+    }
+    // 视频不等待确认：丢失的帧由接收端按 frame_id 发现并请求刷新
+    g_mqtt_ctx.pub_qos = VIDEO_QOS;
+    printf("MQTT连接成功，已订阅主题: %s（%s）\n", TOPIC_SUB,
+           control_split ? "独立控制连接" : "与视频共用连接");
+
+    // 初始化本地环形录像（失败不影响实时推流）
+    if (RECORDER_ENABLE) {
+        recorder_config_t rec_config = {
+            .path = RECORDER_PATH,
+            .slot_count = RECORDER_SLOT_COUNT,
+            .slot_size = RECORDER_SLOT_SIZE,
+            .batch = RECORDER_BATCH,
+            .queue_depth = RECORDER_QUEUE,
+            .flush_ms = RECORDER_FLUSH_MS,
+            .replay_publish = publish_replay_frame,
+        };
+        if (recorder_init(&rec_config) != 0) {
+            fprintf(stderr, "本地录像初始化失败，继续运行\n");
+        }
+    }
+
+    // 创建共享内存帧环（失败不影响实时推流）
+    if (SHMRING_ENABLE &&
+        shmring_create(&g_shmring, SHMRING_NAME, SHMRING_SLOT_COUNT, SHMRING_SLOT_SIZE) != 0) {
+        fprintf(stderr, "共享内存帧环创建失败，继续运行\n");
+    }
+
+    // 注册监听线程的事件：每条MQTT连接的断线通知 + 重连定时器
+    bool reactor_ok = true;
+    for (int i = 0; reactor_ok && i < g_link_count; i++) {
+        g_links[i].timer_fd = reactor_timer_create();
+        reactor_ok = g_links[i].timer_fd >= 0 &&
+            reactor_add(&g_reactor, g_links[i].ctx->notify_fd, EPOLLIN, on_mqtt_event, &g_links[i]) == 0 &&
+            reactor_add(&g_reactor, g_links[i].timer_fd, EPOLLIN, on_mqtt_event, &g_links[i]) == 0;
+    }
+    if (reactor_ok && trace_notify_fd() >= 0) {
+        reactor_ok = reactor_add(&g_reactor, trace_notify_fd(), EPOLLIN, on_trace_event, NULL) == 0;
+    }
+    if (!reactor_ok) {
+        fprintf(stderr, "事件循环初始化失败\n");
+        recorder_close();
+        shmring_destroy(&g_shmring);
+        close_mqtt_links();
+        camera_deinit();
+        close_engine();
+        return 1;
+    }
+
+    // 初始化发送队列
+    if (sendq_init(SENDQ_DEPTH, FRAME_DEADLINE_MS) != 0) {
+        fprintf(stderr, "发送队列初始化失败\n");
+        recorder_close();
+        shmring_destroy(&g_shmring);
+        close_mqtt_links();
+        camera_deinit();
+        close_engine();
         return 1;
     }
-    printf("MQTT连接成功，已订阅主题: %s\n", TOPIC_SUB);
 
     // 创建监听线程
     pthread_t listen_tid;
     if(pthread_create(&listen_tid, NULL, mqtt_listen_thread, NULL) != 0) {
         fprintf(stderr, "线程创建失败\n");
-        mqtt_disconnect(&g_mqtt_ctx);
+        recorder_close();
+        shmring_destroy(&g_shmring);
+        close_mqtt_links();
         camera_deinit();
-        engine_close();
+        close_engine();
         return 1;
     }
 
@@ -179,18 +868,48 @@ int main() {
     pthread_t video_tid;
     if(pthread_create(&video_tid, NULL, video_publish_thread, NULL) != 0) {
         fprintf(stderr, "视频发布线程创建失败\n");
-        mqtt_disconnect(&g_mqtt_ctx);
+        recorder_close();
+        shmring_destroy(&g_shmring);
+        close_mqtt_links();
         camera_deinit();
-        engine_close();
+        close_engine();
+        return 1;
+    }
+
+    // 创建视频采集线程
+    pthread_t capture_tid;
+    if(pthread_create(&capture_tid, NULL, video_capture_thread, NULL) != 0) {
+        fprintf(stderr, "视频采集线程创建失败\n");
+        sendq_shutdown();
+        recorder_close();
+        shmring_destroy(&g_shmring);
+        close_mqtt_links();
+        camera_deinit();
+        close_engine();
         return 1;
     }
     
+    // 快速启动：推流已开始，等待舵机复位完成；舵机不可用时与依次启动一样退出
+    if (wait_servo_init() != 0) {
+        printf("舵机初始化失败，程序退出。\n");
+        g_running = 0;
+        reactor_stop(&g_reactor);
+    }
+    
     pthread_join(listen_tid, NULL);
+    pthread_join(capture_tid, NULL);
     pthread_join(video_tid, NULL);
+    sendq_print_stats();
     
     // 清理资源
-    mqtt_disconnect(&g_mqtt_ctx);
+    reactor_destroy(&g_reactor);
+    sendq_destroy();
+    recorder_close();
+    shmring_destroy(&g_shmring);
+    close_mqtt_links();
     camera_deinit();
-    engine_close();
+    close_engine();
+    // 追踪最后导出：Paho 回调线程、摄像头读取线程与舵机线程到这里才全部退出
+    trace_shutdown();
     return 0;
 }
\ No newline at end of file
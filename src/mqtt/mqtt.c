@@ -1,9 +1,12 @@
 #include "mqtt/mqtt.h"
 #include "engine/engine.h"  // 包含舵机控制头文件
+#include "trace/trace.h"
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
 #include <sys/time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 
 
 // MQTT 消息送达回调函数
@@ -17,6 +20,8 @@ static int msgarrvd(void *context, char *topicName, int topicLen,
     mqtt_ctx* ctx = (mqtt_ctx*)context; // 获取上下文指针
     char* payload = NULL;
 
+    TRACE_BEGIN("msgarrvd");
+
     // 安全检查，确保消息和载荷有效
     if (message && message->payload && message->payloadlen > 0) {
         // 为消息载荷分配内存，并拷贝内容，确保以 '\0' 结尾
@@ -25,11 +30,15 @@ static int msgarrvd(void *context, char *topicName, int topicLen,
             memcpy(payload, message->payload, message->payloadlen);
             payload[message->payloadlen] = '\0';
 
-            // 如果主题名等于 TOPIC_SUB，则打印消息内容并调用回调处理数据
-            if(topicName && strcmp(topicName, TOPIC_SUB) == 0) {
+            // 如果主题名等于订阅主题，则调用回调处理数据
+            if(topicName && ctx->sub_topic[0] && strcmp(topicName, ctx->sub_topic) == 0) {
                 if(ctx->handler) {
                     ctx->handler(payload);// 调用舵机库的解析函数
                 }
+            } else if (topicName && ctx->presence_topic[0] && strcmp(topicName, ctx->presence_topic) == 0) {
+                if (ctx->presence_handler) {
+                    ctx->presence_handler(payload);
+                }
             }
         } else {
             fprintf(stderr, "内存分配失败\n");
@@ -44,100 +53,427 @@ static int msgarrvd(void *context, char *topicName, int topicLen,
     MQTTClient_freeMessage(&message);
     // 释放主题名字符串
     if (topicName) MQTTClient_free(topicName);
+    TRACE_END("msgarrvd");
     // 返回 1 表示消息已处理
     return 1;
 }
 
-// 尝试重连 MQTT 服务器的函数
-static int reconnect_mqtt(mqtt_ctx* ctx) {
+// 获取 CLOCK_MONOTONIC 毫秒时间戳，避免系统时间变化影响
+static unsigned long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+// 唤醒事件循环，由 mqtt_loop 处理连接状态变化
+static void notify_loop(mqtt_ctx* ctx) {
+    if (ctx->notify_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t ret = write(ctx->notify_fd, &one, sizeof(one));
+        (void)ret;
+    }
+}
+
+// 解析逗号分隔的服务器列表
+static int parse_brokers(mqtt_ctx* ctx, const char* address) {
+    const char* p = address;
+
+    ctx->broker_count = 0;
+    while (p && *p && ctx->broker_count < MQTT_MAX_BROKERS) {
+        const char* comma = strchr(p, ',');
+        size_t len = comma ? (size_t)(comma - p) : strlen(p);
+        while (len > 0 && *p == ' ') {
+            p++;
+            len--;
+        }
+        if (len > 0 && len < sizeof(ctx->brokers[0])) {
+            memcpy(ctx->brokers[ctx->broker_count], p, len);
+            ctx->brokers[ctx->broker_count][len] = '\0';
+            ctx->broker_count++;
+        } else if (len > 0) {
+            fprintf(stderr, "服务器地址过长，已忽略\n");
+        }
+        p = comma ? comma + 1 : NULL;
+    }
+    return ctx->broker_count;
+}
+
+static void connlost(void *context, char *cause);
+
+// 创建客户端并设置回调；version 为 MQTTVERSION_5 时创建 MQTT 5 客户端
+static int create_client(mqtt_ctx* ctx, MQTTClient* client, int version) {
+    MQTTClient_createOptions create_opts = MQTTClient_createOptions_initializer;
+    int rc;
+
+    create_opts.MQTTVersion = version;
+    if ((rc = MQTTClient_createWithOptions(client, ctx->brokers[0], ctx->client_id,
+                                           MQTTCLIENT_PERSISTENCE_NONE, NULL, &create_opts)) != MQTTCLIENT_SUCCESS) {
+        fprintf(stderr, "创建客户端失败: %d\n", rc);
+        *client = NULL;
+        return rc;
+    }
+    
+    // 设置回调函数，包括连接丢失、消息到达、消息送达
+    if ((rc = MQTTClient_setCallbacks(*client, ctx, connlost, msgarrvd, delivered)) != MQTTCLIENT_SUCCESS) {
+        fprintf(stderr, "设置回调失败: %d\n", rc);
+        MQTTClient_destroy(client);
+        *client = NULL;
+        return rc;
+    }
+    return MQTTCLIENT_SUCCESS;
+}
+
+// 销毁所有客户端实例
+static void destroy_clients(mqtt_ctx* ctx) {
+    if (ctx->client5) {
+        MQTTClient_destroy(&ctx->client5);
+    }
+    if (ctx->client311) {
+        MQTTClient_destroy(&ctx->client311);
+    }
+    ctx->client = NULL;
+}
+
+// 订阅一个主题，MQTT 5 客户端须使用 subscribe5
+static int subscribe_topic(mqtt_ctx* ctx, MQTTClient client, int version, const char* topic) {
+    if (version >= MQTTVERSION_5) {
+        MQTTResponse response = MQTTClient_subscribe5(client, topic, ctx->sub_qos, NULL, NULL);
+        int rc = response.reasonCode;
+        MQTTResponse_free(response);
+        // 成功时返回授予的QoS，0x80及以上为服务器拒绝
+        if (rc >= 0x80) {
+            rc = MQTTCLIENT_FAILURE;
+        }
+        return rc < 0 ? rc : MQTTCLIENT_SUCCESS;
+    }
+    return MQTTClient_subscribe(client, topic, ctx->sub_qos);
+}
+
+// 服务器是否因不支持 MQTT 5 而拒绝连接：
+// 3.1.1 服务器以 CONNACK 返回码1（不接受的协议版本）拒绝，MQTT 5 服务器返回 0x84
+static int version_rejected(int rc) {
+    return rc == 1 || rc == MQTTREASONCODE_UNSUPPORTED_PROTOCOL_VERSION;
+}
+
+// 使用 MQTT 5 连接，取得服务器允许的主题别名数
+static int connect_v5(mqtt_ctx* ctx, char** uris, int* alias_max) {
+    MQTTClient_connectOptions conn_opts = MQTTClient_connectOptions_initializer5;
+    MQTTResponse response;
+    int rc;
+
+    conn_opts.keepAliveInterval = ctx->keepalive;
+    conn_opts.cleanstart = 1;         // 不保留会话，与 3.1.1 的 cleansession 相同
+    conn_opts.connectTimeout = MQTT_CONNECT_TIMEOUT;
+    conn_opts.serverURIs = uris;
+    conn_opts.serverURIcount = 1;
+
+    response = MQTTClient_connect5(ctx->client5, &conn_opts, NULL, NULL);
+    rc = response.reasonCode;
+    *alias_max = 0;
+    if (rc == MQTTCLIENT_SUCCESS && response.properties &&
+        MQTTProperties_hasProperty(response.properties, MQTTPROPERTY_CODE_TOPIC_ALIAS_MAXIMUM)) {
+        *alias_max = MQTTProperties_getNumericValue(response.properties,
+                                                    MQTTPROPERTY_CODE_TOPIC_ALIAS_MAXIMUM);
+    }
+    MQTTResponse_free(response);
+    return rc;
+}
+
+// 使用 MQTT 3.1.1 连接
+static int connect_v311(mqtt_ctx* ctx, char** uris) {
     // 初始化连接参数结构体
     MQTTClient_connectOptions conn_opts = MQTTClient_connectOptions_initializer;
-    int rc;
     
     // 设置连接参数
-    conn_opts.keepAliveInterval = 20; // 保活时间
+    conn_opts.keepAliveInterval = ctx->keepalive; // 保活时间
     conn_opts.cleansession = 1;       // 清除会话
-    conn_opts.connectTimeout = DEFAULT_TIMEOUT; // 连接超时时间
+    conn_opts.connectTimeout = MQTT_CONNECT_TIMEOUT; // 连接超时时间（秒）
+    // 同一客户端通过 serverURIs 切换服务器，覆盖创建时的地址
+    conn_opts.serverURIs = uris;
+    conn_opts.serverURIcount = 1;
     
-    // 尝试重新连接
-    if ((rc = MQTTClient_connect(ctx->client, &conn_opts)) != MQTTCLIENT_SUCCESS) {
-        fprintf(stderr, "重连失败: %d，将在%d毫秒后重试\n", rc, RECONNECT_INTERVAL);
-        return rc;
+    return MQTTClient_connect(ctx->client311, &conn_opts);
+}
+
+// 连接指定服务器并订阅主题（阻塞，最长约 MQTT_CONNECT_TIMEOUT 秒）
+static int connect_broker(mqtt_ctx* ctx, int index) {
+    char* uris[1] = { ctx->brokers[index] };
+    MQTTClient client = NULL;
+    int version = MQTTVERSION_3_1_1;
+    int alias_max = 0;
+    int dropped = 0;
+    int rc = MQTTCLIENT_FAILURE;
+    
+    // 优先 MQTT 5；服务器明确拒绝该协议版本时改用 3.1.1，并记住该服务器只支持 3.1.1。
+    // 部分 3.1.1 服务器收到 MQTT 5 的 CONNECT 直接断开TCP（返回 -1 等负值），此时很快失败，
+    // 本次以 3.1.1 重试但不记住，下次重连仍先尝试 MQTT 5；网络中断时连接超时才失败，不重试，
+    // 避免断网期间每次重连都连两次、把恢复后的 MQTT 5 服务器误降级
+    if (ctx->client5 && !ctx->v311_only[index]) {
+        unsigned long start = now_ms();
+        rc = connect_v5(ctx, uris, &alias_max);
+        if (rc == MQTTCLIENT_SUCCESS) {
+            client = ctx->client5;
+            version = MQTTVERSION_5;
+        } else if (version_rejected(rc)) {
+            printf("%s 不支持MQTT 5，改用3.1.1\n", ctx->brokers[index]);
+            ctx->v311_only[index] = 1;
+        } else if (rc < 0 && now_ms() - start < MQTT_CONNECT_TIMEOUT * 1000UL / 2) {
+            dropped = 1;
+        } else {
+            return rc;
+        }
+    }
+    if (rc != MQTTCLIENT_SUCCESS) {
+        if (!ctx->client311 &&
+            (rc = create_client(ctx, &ctx->client311, MQTTVERSION_DEFAULT)) != MQTTCLIENT_SUCCESS) {
+            return rc;
+        }
+        if ((rc = connect_v311(ctx, uris)) != MQTTCLIENT_SUCCESS) {
+            return rc;
+        }
+        if (dropped) {
+            printf("%s 断开了MQTT 5连接，本次改用3.1.1\n", ctx->brokers[index]);
+        }
+        client = ctx->client311;
     }
     
-    // 重新订阅主题，确保断线重连后还能收到消息
-    if ((rc = MQTTClient_subscribe(ctx->client, TOPIC_SUB, DEFAULT_QOS)) != MQTTCLIENT_SUCCESS) {
-        fprintf(stderr, "重新订阅失败: %d\n", rc);
+    // 订阅主题；cleansession 下重连后必须重新订阅才能继续收到消息
+    if (ctx->sub_topic[0] &&
+        (rc = subscribe_topic(ctx, client, version, ctx->sub_topic)) != MQTTCLIENT_SUCCESS) {
+        fprintf(stderr, "订阅失败: %d\n", rc);
+        MQTTClient_disconnect(client, 0);
         return rc;
     }
+    if (ctx->presence_topic[0] &&
+        (rc = subscribe_topic(ctx, client, version, ctx->presence_topic)) != MQTTCLIENT_SUCCESS) {
+        fprintf(stderr, "订阅观看者主题失败: %d\n", rc);
+        MQTTClient_disconnect(client, 0);
+        return rc;
+    }
+    
+    // 主题别名只在本次连接内有效，重连后重新建立
+    pthread_mutex_lock(&ctx->alias_lock);
+    ctx->alias_count = 0;
+    ctx->alias_max = alias_max < MQTT5_TOPIC_ALIAS_MAX ? alias_max : MQTT5_TOPIC_ALIAS_MAX;
+    pthread_mutex_unlock(&ctx->alias_lock);
     
-    printf("MQTT重连成功\n");
+    // 断线期间不会发布，此时切换客户端是安全的；旧客户端保留到 mqtt_disconnect 才销毁
+    ctx->client = client;
+    ctx->protocol = version;
+    ctx->connected = 1;
     return MQTTCLIENT_SUCCESS;
 }
 
+// 后台重连线程：连接当前服务器，结束后通知事件循环回收
+static void* connect_thread(void* arg) {
+    mqtt_ctx* ctx = (mqtt_ctx*)arg;
+    ctx->connect_rc = connect_broker(ctx, ctx->broker_index);
+    ctx->connect_done = 1;
+    notify_loop(ctx);
+    return NULL;
+}
+
+// 计算下一次重连延迟：指数退避，取 [退避/2, 退避] 之间的随机值，避免多台设备同时重连
+static long next_backoff(mqtt_ctx* ctx) {
+    if (ctx->backoff_ms == 0) {
+        ctx->backoff_ms = RECONNECT_INITIAL_MS;
+    } else if (ctx->backoff_ms < RECONNECT_INTERVAL) {
+        ctx->backoff_ms *= 2;
+        if (ctx->backoff_ms > RECONNECT_INTERVAL) {
+            ctx->backoff_ms = RECONNECT_INTERVAL;
+        }
+    }
+    long half = ctx->backoff_ms / 2;
+    return half + (long)(rand_r(&ctx->jitter_seed) % (half + 1));
+}
+
 // 连接丢失回调函数
 // 当与 MQTT 服务器的连接断开时会被调用
 static void connlost(void *context, char *cause) {
     mqtt_ctx* ctx = (mqtt_ctx*)context;
     fprintf(stderr, "连接丢失，原因: %s\n", cause);
     
-    // 标记连接状态为断开，后续由主循环处理重连
+    // 标记连接状态为断开，后续由事件循环处理重连
     ctx->connected = 0;
-    // 重连逻辑在 mqtt_loop 中处理
+    // 唤醒事件循环，重连逻辑在 mqtt_loop 中处理
+    notify_loop(ctx);
 }
 
-// 初始化 MQTT 连接
+// 初始化 MQTT 连接（使用默认服务器列表和客户端ID）
 int mqtt_init(mqtt_ctx* ctx, message_handler handler) {
-    MQTTClient_connectOptions conn_opts = MQTTClient_connectOptions_initializer;
+    return mqtt_init_with(ctx, handler, BROKER_LIST, DEFAULT_CLIENT_ID);
+}
+
+// 使用指定服务器地址和客户端ID初始化 MQTT 连接
+int mqtt_init_with(mqtt_ctx* ctx, message_handler handler,
+                   const char* address, const char* client_id) {
+    mqtt_options_t options = {
+        .client_id = client_id,
+        .sub_topic = TOPIC_SUB,
+        .qos = DEFAULT_QOS,
+        .keepalive = MQTT_KEEPALIVE,
+        .mqtt5 = MQTT5_ENABLE,
+        .message_expiry = MQTT5_MESSAGE_EXPIRY,
+    };
+    return mqtt_init_opts(ctx, handler, address, &options);
+}
+
+// 使用指定连接参数初始化 MQTT 连接
+int mqtt_init_opts(mqtt_ctx* ctx, message_handler handler,
+                   const char* address, const mqtt_options_t* options) {
     int rc;
     
     // 初始化上下文结构体，清零
     memset(ctx, 0, sizeof(mqtt_ctx));
+    ctx->notify_fd = -1;
     ctx->handler = handler;      // 设置用户消息处理回调
+    ctx->sub_qos = options->qos;
+    ctx->pub_qos = DEFAULT_QOS;
+    ctx->keepalive = options->keepalive;
+    ctx->message_expiry = options->mqtt5 ? options->message_expiry : 0;
+    snprintf(ctx->client_id, sizeof(ctx->client_id), "%s", options->client_id);
+    pthread_mutex_init(&ctx->alias_lock, NULL);
+    if (options->sub_topic) {
+        snprintf(ctx->sub_topic, sizeof(ctx->sub_topic), "%s", options->sub_topic);
+    }
+    if (options->presence_topic) {
+        snprintf(ctx->presence_topic, sizeof(ctx->presence_topic), "%s", options->presence_topic);
+        ctx->presence_handler = options->presence_handler;
+    }
     ctx->connected = 0;          // 初始为未连接
     ctx->last_reconnect = 0;     // 上次重连时间初始化
+    ctx->jitter_seed = (unsigned int)(now_ms() ^ (unsigned long)getpid());
     
-    // 创建 MQTT 客户端实例
-    if ((rc = MQTTClient_create(&ctx->client, DEFAULT_ADDRESS, DEFAULT_CLIENT_ID,
-                              MQTTCLIENT_PERSISTENCE_NONE, NULL)) != MQTTCLIENT_SUCCESS) {
-        fprintf(stderr, "创建客户端失败: %d\n", rc);
-        return rc;
+    if (parse_brokers(ctx, address) == 0) {
+        fprintf(stderr, "没有有效的MQTT服务器地址\n");
+        pthread_mutex_destroy(&ctx->alias_lock);
+        return -1;
     }
     
-    // 设置回调函数，包括连接丢失、消息到达、消息送达
-    if ((rc = MQTTClient_setCallbacks(ctx->client, ctx, connlost, msgarrvd, delivered)) != MQTTCLIENT_SUCCESS) {
-        fprintf(stderr, "设置回调失败: %d\n", rc);
-        MQTTClient_destroy(&ctx->client);
-        return rc;
+    // 创建连接状态通知描述符
+    ctx->notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ctx->notify_fd < 0) {
+        perror("创建通知描述符失败");
+        pthread_mutex_destroy(&ctx->alias_lock);
+        return -1;
     }
     
-    // 设置连接参数
-    conn_opts.keepAliveInterval = 20; // 保活时间
-    conn_opts.cleansession = 1;       // 清除会话
-    conn_opts.connectTimeout = DEFAULT_TIMEOUT; // 连接超时时间
-    
-    // 建立与 MQTT 服务器的连接
-    if ((rc = MQTTClient_connect(ctx->client, &conn_opts)) != MQTTCLIENT_SUCCESS) {
-        fprintf(stderr, "连接失败: %d\n", rc);
-        MQTTClient_destroy(&ctx->client);
+    // 创建 MQTT 客户端实例；启用 MQTT 5 时先只创建 MQTT 5 客户端，3.1.1 客户端在回退时创建
+    if ((rc = create_client(ctx, options->mqtt5 ? &ctx->client5 : &ctx->client311,
+                            options->mqtt5 ? MQTTVERSION_5 : MQTTVERSION_DEFAULT)) != MQTTCLIENT_SUCCESS) {
+        close(ctx->notify_fd);
+        ctx->notify_fd = -1;
+        pthread_mutex_destroy(&ctx->alias_lock);
         return rc;
     }
     
-    // 订阅指定主题，确保能收到消息
-    if ((rc = MQTTClient_subscribe(ctx->client, TOPIC_SUB, DEFAULT_QOS)) != MQTTCLIENT_SUCCESS) {
-        fprintf(stderr, "订阅失败: %d\n", rc);
-        MQTTClient_disconnect(ctx->client, DEFAULT_TIMEOUT);
-        MQTTClient_destroy(&ctx->client);
+    // 按列表顺序尝试建立连接并订阅主题
+    rc = -1;
+    for (int i = 0; i < ctx->broker_count; i++) {
+        if ((rc = connect_broker(ctx, i)) == MQTTCLIENT_SUCCESS) {
+            ctx->broker_index = i;
+            break;
+        }
+        fprintf(stderr, "连接 %s 失败: %d\n", ctx->brokers[i], rc);
+    }
+    if (rc != MQTTCLIENT_SUCCESS) {
+        destroy_clients(ctx);
+        close(ctx->notify_fd);
+        ctx->notify_fd = -1;
+        pthread_mutex_destroy(&ctx->alias_lock);
         return rc;
     }
     
-    ctx->connected = 1; // 标记为已连接
+    printf("MQTT已连接: %s (客户端 %s, MQTT %s)\n", ctx->brokers[ctx->broker_index], options->client_id,
+           ctx->protocol >= MQTTVERSION_5 ? "5" : "3.1.1");
     return MQTTCLIENT_SUCCESS;
 }
 
-// 发布消息到指定主题
+// 查找或分配主题别名（调用者持有 alias_lock），返回别名，0表示不使用别名
+static int topic_alias(mqtt_ctx* ctx, const char* topic) {
+    for (int i = 0; i < ctx->alias_count; i++) {
+        if (strcmp(ctx->aliases[i].topic, topic) == 0) {
+            return i + 1;
+        }
+    }
+    if (ctx->alias_count >= ctx->alias_max || strlen(topic) >= sizeof(ctx->aliases[0].topic)) {
+        return 0;
+    }
+    mqtt_topic_alias_t* entry = &ctx->aliases[ctx->alias_count++];
+    snprintf(entry->topic, sizeof(entry->topic), "%s", topic);
+    entry->established = 0;
+    return ctx->alias_count;
+}
+
+/**
+ * 提交一条消息
+ * MQTT 5 连接附带消息过期时间和内容类型，并使用主题别名：
+ * 首条消息携带完整主题与别名，之后主题为空串、只带别名。
+ * 别名的查找与提交在同一把锁内完成，多个线程发布同一主题时建立别名的消息一定先提交。
+ */
+static int publish_message(mqtt_ctx* ctx, const char* topic, MQTTClient_message* pubmsg,
+                           const char* content_type, MQTTClient_deliveryToken* token) {
+    MQTTProperties props = MQTTProperties_initializer;
+    MQTTProperty prop;
+    MQTTResponse response;
+    const char* send_topic = topic;
+    int alias, rc;
+
+    if (ctx->protocol < MQTTVERSION_5) {
+        return MQTTClient_publishMessage(ctx->client, topic, pubmsg, token);
+    }
+
+    if (ctx->message_expiry > 0) {
+        prop.identifier = MQTTPROPERTY_CODE_MESSAGE_EXPIRY_INTERVAL;
+        prop.value.integer4 = (unsigned int)ctx->message_expiry;
+        MQTTProperties_add(&props, &prop);
+    }
+    if (content_type && content_type[0]) {
+        prop.identifier = MQTTPROPERTY_CODE_CONTENT_TYPE;
+        prop.value.data.data = (char*)content_type;
+        prop.value.data.len = (int)strlen(content_type);
+        MQTTProperties_add(&props, &prop);
+    }
+
+    pthread_mutex_lock(&ctx->alias_lock);
+    alias = topic_alias(ctx, topic);
+    if (alias > 0) {
+        prop.identifier = MQTTPROPERTY_CODE_TOPIC_ALIAS;
+        prop.value.integer2 = (unsigned short)alias;
+        MQTTProperties_add(&props, &prop);
+        if (ctx->aliases[alias - 1].established) {
+            send_topic = "";
+        }
+    }
+    pubmsg->properties = props;
+    response = MQTTClient_publishMessage5(ctx->client, send_topic, pubmsg, token);
+    rc = response.reasonCode;
+    if (alias > 0 && rc == MQTTCLIENT_SUCCESS) {
+        ctx->aliases[alias - 1].established = 1;
+    }
+    pthread_mutex_unlock(&ctx->alias_lock);
+
+    MQTTResponse_free(response);
+    MQTTProperties_free(&props);
+    return rc;
+}
+
+// 发布消息到指定主题（使用 ctx->pub_qos）
 int mqtt_publish(mqtt_ctx* ctx, const char* topic, 
                 const void* payload, size_t payload_len) {
+    return mqtt_publish_qos(ctx, topic, payload, payload_len, ctx ? ctx->pub_qos : 0);
+}
+
+// 以指定服务质量等级发布消息，不带内容类型
+int mqtt_publish_qos(mqtt_ctx* ctx, const char* topic,
+                     const void* payload, size_t payload_len, int qos) {
+    return mqtt_publish_typed(ctx, topic, payload, payload_len, qos, NULL);
+}
+
+// 以指定服务质量等级和内容类型发布消息
+int mqtt_publish_typed(mqtt_ctx* ctx, const char* topic,
+                       const void* payload, size_t payload_len, int qos,
+                       const char* content_type) {
     MQTTClient_message pubmsg = MQTTClient_message_initializer;
     MQTTClient_deliveryToken token;
     int rc;
@@ -157,56 +493,234 @@ int mqtt_publish(mqtt_ctx* ctx, const char* topic,
     // 设置消息内容
     pubmsg.payload = (void*)payload;
     pubmsg.payloadlen = (int)payload_len;
-    pubmsg.qos = DEFAULT_QOS; // 服务质量
+    pubmsg.qos = qos;         // 服务质量
     pubmsg.retained = 0;      // 不保留消息
     
     // 发布消息
-    rc = MQTTClient_publishMessage(ctx->client, topic, &pubmsg, &token);
+    TRACE_BEGIN("mqtt_publish");
+    rc = publish_message(ctx, topic, &pubmsg, content_type, &token);
+    TRACE_END("mqtt_publish");
     if (rc != MQTTCLIENT_SUCCESS) {
         fprintf(stderr, "发布失败: %d\n", rc);
         return rc;
     }
     
+    // QoS 0 没有确认，写入套接字即完成
+    if (qos == 0) {
+        return MQTTCLIENT_SUCCESS;
+    }
+    
     // 等待消息送达服务器（可选，保证消息已发送）
-    if ((rc = MQTTClient_waitForCompletion(ctx->client, token, DEFAULT_TIMEOUT)) != MQTTCLIENT_SUCCESS) {
+    TRACE_BEGIN("mqtt_ack");
+    rc = MQTTClient_waitForCompletion(ctx->client, token, DEFAULT_TIMEOUT);
+    TRACE_END("mqtt_ack");
+    if (rc != MQTTCLIENT_SUCCESS) {
         fprintf(stderr, "等待完成失败: %d\n", rc);
     }
     return rc;
 }
 
-// MQTT 主循环，需在主线程定期调用
-void mqtt_loop(mqtt_ctx* ctx) {
-    // 获取当前时间（毫秒）
-    struct timespec ts;
-    unsigned long current_time;
-    
-    // 使用 CLOCK_MONOTONIC 获取系统启动到现在的时间，避免系统时间变化影响
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    current_time = (unsigned long)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
-    
-    // 检查连接状态
+// 按行带分片发布一帧图像
+int mqtt_publish_chunked(mqtt_ctx* ctx, const char* topic, uint32_t frame_id,
+                         const void* data, size_t data_len,
+                         const frame_layout_t* layout, size_t chunk_bytes, int qos) {
+    MQTTClient_deliveryToken tokens[CHUNK_MAX_INFLIGHT];
+    size_t row_bytes, rows_per_chunk, chunk_count, msg_size, prefix, header_len;
+    unsigned char* buffer;
+    int rc = MQTTCLIENT_SUCCESS;
+    int foveated = layout && (layout->flags & FRAME_FLAG_FOVEATED);
+
+    // 参数检查，确保上下文、主题、图像数据和尺寸有效
+    if (!ctx || !topic || !data || data_len == 0 || !layout ||
+        layout->width == 0 || layout->height == 0 ||
+        (!foveated && data_len % layout->height != 0) ||
+        (layout->palette_len > 0 && !layout->palette)) {
+        fprintf(stderr, "分片发布参数无效\n");
+        return -1;
+    }
     if (!ctx->connected) {
-        // 如果距离上次重连已超过设定间隔，则尝试重连
-        if (current_time - ctx->last_reconnect >= RECONNECT_INTERVAL) {
-            printf("尝试重新连接MQTT服务器...\n");
-            if (reconnect_mqtt(ctx) == MQTTCLIENT_SUCCESS) {
-                ctx->connected = 1;
+        fprintf(stderr, "MQTT未连接，无法发布\n");
+        return -2;
+    }
+
+    // 分片大小按整行取整，至少一行；注视区域编码的数据不按行排列，整帧作为一个分片
+    row_bytes = data_len / layout->height;
+    rows_per_chunk = foveated ? layout->height : chunk_bytes / row_bytes;
+    if (rows_per_chunk == 0) {
+        rows_per_chunk = 1;
+    }
+    chunk_count = (layout->height + rows_per_chunk - 1) / rows_per_chunk;
+    header_len = sizeof(frame_chunk_header_t) + (foveated ? sizeof(frame_roi_t) : 0);
+    prefix = header_len + layout->palette_len;
+    msg_size = prefix + (foveated ? data_len : rows_per_chunk * row_bytes);
+
+    // 所有分片一次性组装在同一块内存中，避免逐片申请
+    buffer = (unsigned char*)malloc(msg_size * chunk_count);
+    if (!buffer) {
+        fprintf(stderr, "内存分配失败\n");
+        return -1;
+    }
+
+    for (size_t i = 0; i < chunk_count; i++) {
+        MQTTClient_message pubmsg = MQTTClient_message_initializer;
+        unsigned char* msg = buffer + i * msg_size;
+        frame_chunk_header_t* header = (frame_chunk_header_t*)msg;
+        size_t row_start = i * rows_per_chunk;
+        size_t row_count = (row_start + rows_per_chunk > layout->height) ?
+                           layout->height - row_start : rows_per_chunk;
+
+        header->magic = FRAME_CHUNK_MAGIC;
+        header->header_len = (uint16_t)header_len;
+        header->frame_id = frame_id;
+        header->frame_len = (uint32_t)data_len;
+        header->chunk_index = (uint16_t)i;
+        header->chunk_count = (uint16_t)chunk_count;
+        header->chunk_offset = foveated ? 0 : (uint32_t)(row_start * row_bytes);
+        header->chunk_len = foveated ? (uint32_t)data_len : (uint32_t)(row_count * row_bytes);
+        header->row_start = (uint16_t)row_start;
+        header->row_count = (uint16_t)row_count;
+        header->width = layout->width;
+        header->height = layout->height;
+        header->pixel_format = layout->pixel_format;
+        header->flags = layout->flags;
+        header->palette_len = layout->palette_len;
+        if (foveated) {
+            memcpy(msg + sizeof(frame_chunk_header_t), &layout->roi, sizeof(frame_roi_t));
+        }
+        if (layout->palette_len > 0) {
+            memcpy(msg + header_len, layout->palette, layout->palette_len);
+        }
+        memcpy(msg + prefix, (const unsigned char*)data + header->chunk_offset, header->chunk_len);
+
+        // 限制同时在途的分片数，等待最早的分片确认后再继续，平滑链路突发（QoS 0 没有确认）
+        if (qos > 0 && i >= CHUNK_MAX_INFLIGHT) {
+            TRACE_BEGIN("mqtt_ack");
+            rc = MQTTClient_waitForCompletion(ctx->client, tokens[i % CHUNK_MAX_INFLIGHT],
+                                              DEFAULT_TIMEOUT);
+            TRACE_END("mqtt_ack");
+            if (rc != MQTTCLIENT_SUCCESS) {
+                fprintf(stderr, "等待分片确认失败: %d\n", rc);
+                break;
             }
-            ctx->last_reconnect = current_time;
         }
-    } else {
-        // 维持网络流量，处理收发缓冲区（异步模式需要）
-        MQTTClient_yield();
+
+        pubmsg.payload = msg;
+        pubmsg.payloadlen = (int)(prefix + header->chunk_len);
+        pubmsg.qos = qos;
+        pubmsg.retained = 0;
+        TRACE_BEGIN("mqtt_publish");
+        rc = publish_message(ctx, topic, &pubmsg, MQTT5_CONTENT_TYPE_CHUNK,
+                             &tokens[i % CHUNK_MAX_INFLIGHT]);
+        TRACE_END("mqtt_publish");
+        if (rc != MQTTCLIENT_SUCCESS) {
+            fprintf(stderr, "分片发布失败: %d (分片 %zu/%zu)\n", rc, i, chunk_count);
+            break;
+        }
+    }
+
+    // 等待剩余分片确认
+    if (rc == MQTTCLIENT_SUCCESS && qos > 0) {
+        size_t first = chunk_count > CHUNK_MAX_INFLIGHT ? chunk_count - CHUNK_MAX_INFLIGHT : 0;
+        for (size_t i = first; i < chunk_count; i++) {
+            TRACE_BEGIN("mqtt_ack");
+            rc = MQTTClient_waitForCompletion(ctx->client, tokens[i % CHUNK_MAX_INFLIGHT],
+                                              DEFAULT_TIMEOUT);
+            TRACE_END("mqtt_ack");
+            if (rc != MQTTCLIENT_SUCCESS) {
+                fprintf(stderr, "等待分片确认失败: %d\n", rc);
+                break;
+            }
+        }
+    }
+
+    free(buffer);
+    return rc;
+}
+
+// MQTT 连接维护：由事件循环在断线通知或重连定时器到期时调用
+long mqtt_loop(mqtt_ctx* ctx) {
+    unsigned long current_time = now_ms();
+    
+    // 回收已结束的重连线程
+    if (ctx->connecting) {
+        if (!ctx->connect_done) {
+            return -1; // 仍在连接，等待线程通知
+        }
+        pthread_join(ctx->connect_tid, NULL);
+        ctx->connecting = 0;
+        
+        if (ctx->connect_rc == MQTTCLIENT_SUCCESS && ctx->connected) {
+            ctx->reconnects++;
+            printf("MQTT重连成功: %s，断线 %lu 毫秒，尝试 %d 次\n",
+                   ctx->brokers[ctx->broker_index], current_time - ctx->lost_at, ctx->attempts);
+            ctx->attempts = 0;
+            ctx->broker_attempts = 0;
+            ctx->backoff_ms = 0;
+            ctx->lost_at = 0;
+            return -1;
+        }
+        
+        // 连接失败（或刚连上又断开）：必要时切换服务器，按退避间隔重试
+        ctx->broker_attempts++;
+        if (MAX_RECONNECT_ATTEMPTS > 0 && ctx->broker_count > 1 &&
+            ctx->broker_attempts >= MAX_RECONNECT_ATTEMPTS) {
+            ctx->broker_index = (ctx->broker_index + 1) % ctx->broker_count;
+            ctx->broker_attempts = 0;
+            printf("切换到MQTT服务器: %s\n", ctx->brokers[ctx->broker_index]);
+        }
+        long delay = next_backoff(ctx);
+        ctx->next_reconnect = current_time + delay;
+        fprintf(stderr, "重连失败: %d，将在%ld毫秒后重试\n", ctx->connect_rc, delay);
+        return delay;
+    }
+    
+    // 已连接时收发由 Paho 后台线程（已设置回调）完成，无需 MQTTClient_yield 轮询
+    if (ctx->connected) {
+        return -1;
+    }
+    
+    // 刚发现断线：首次重试立即进行
+    if (ctx->lost_at == 0) {
+        ctx->lost_at = current_time;
+        ctx->next_reconnect = current_time;
+    }
+    if (current_time < ctx->next_reconnect) {
+        return (long)(ctx->next_reconnect - current_time);
+    }
+    
+    printf("尝试重新连接MQTT服务器 %s...\n", ctx->brokers[ctx->broker_index]);
+    ctx->last_reconnect = current_time;
+    ctx->attempts++;
+    ctx->connect_done = 0;
+    if (pthread_create(&ctx->connect_tid, NULL, connect_thread, ctx) != 0) {
+        fprintf(stderr, "重连线程创建失败\n");
+        long delay = next_backoff(ctx);
+        ctx->next_reconnect = current_time + delay;
+        return delay;
     }
+    ctx->connecting = 1;
+    return -1;
 }
 
 // 断开 MQTT 连接并释放资源
 void mqtt_disconnect(mqtt_ctx* ctx) {
+    // 等待进行中的重连结束（最长 MQTT_CONNECT_TIMEOUT 秒）
+    if (ctx && ctx->connecting) {
+        pthread_join(ctx->connect_tid, NULL);
+        ctx->connecting = 0;
+    }
     if (ctx && ctx->client) {
         ctx->connected = 0; // 标记为断开连接
         // 断开与服务器的连接
         MQTTClient_disconnect(ctx->client, DEFAULT_TIMEOUT);
+    }
+    if (ctx) {
         // 销毁客户端实例，释放资源
-        MQTTClient_destroy(&ctx->client);
+        destroy_clients(ctx);
+        pthread_mutex_destroy(&ctx->alias_lock);
     }
-}
\ No newline at end of file
+    if (ctx && ctx->notify_fd >= 0) {
+        close(ctx->notify_fd);
+        ctx->notify_fd = -1;
+    }
+}
@@ -0,0 +1,216 @@
+#include "presence/presence.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <cjson/cJSON.h>
+
+// 单个观看者租约
+typedef struct {
+    char id[32];
+    uint64_t expires_us;         // 0 表示空闲槽位
+} viewer_lease_t;
+
+static bool presence_on = false;
+static viewer_lease_t leases[PRESENCE_MAX_VIEWERS];
+static presence_stats_t stats;
+static bool suspended = false;
+static uint64_t suspended_at_us = 0;
+static uint64_t wake_us = 0;     // 暂停期间第一个心跳到达时刻
+static pthread_mutex_t presence_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t presence_cond;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// 统计未过期的租约数（需持有锁）
+static int count_viewers(uint64_t now) {
+    int count = 0;
+    for (int i = 0; i < PRESENCE_MAX_VIEWERS; i++) {
+        if (leases[i].expires_us > now) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// 初始化
+void presence_init(bool enabled) {
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&presence_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    memset(leases, 0, sizeof(leases));
+    memset(&stats, 0, sizeof(stats));
+    presence_on = enabled;
+    if (enabled) {
+        printf("按需推流已启用：观看者心跳主题 %s，默认租约 %d ms\n", TOPIC_VIEWER, PRESENCE_LEASE_MS);
+    }
+}
+
+bool presence_enabled(void) {
+    return presence_on;
+}
+
+// 处理心跳消息：续租、新增或离开
+void presence_handle(const char *payload) {
+    cJSON *root = cJSON_Parse(payload);
+    cJSON *viewer_obj, *lease_obj, *leave_obj;
+    uint64_t now = now_us();
+    int lease_ms = PRESENCE_LEASE_MS;
+    int slot = -1, free_slot = -1;
+
+    if (!root) {
+        printf("观看者心跳解析失败\n");
+        return;
+    }
+    viewer_obj = cJSON_GetObjectItem(root, "viewer");
+    lease_obj = cJSON_GetObjectItem(root, "lease_ms");
+    leave_obj = cJSON_GetObjectItem(root, "leave");
+    if (!viewer_obj || !cJSON_IsString(viewer_obj) || !viewer_obj->valuestring[0]) {
+        printf("观看者心跳缺少 viewer 字段\n");
+        cJSON_Delete(root);
+        return;
+    }
+    if (lease_obj && cJSON_IsNumber(lease_obj) && lease_obj->valueint > 0) {
+        lease_ms = lease_obj->valueint < PRESENCE_MAX_LEASE_MS ? lease_obj->valueint : PRESENCE_MAX_LEASE_MS;
+    }
+
+    pthread_mutex_lock(&presence_lock);
+    int before = count_viewers(now);
+    for (int i = 0; i < PRESENCE_MAX_VIEWERS; i++) {
+        if (leases[i].expires_us > now && strncmp(leases[i].id, viewer_obj->valuestring, sizeof(leases[i].id) - 1) == 0) {
+            slot = i;
+            break;
+        }
+        if (free_slot < 0 && leases[i].expires_us <= now) {
+            free_slot = i;
+        }
+    }
+
+    if (leave_obj && cJSON_IsTrue(leave_obj)) {
+        if (slot >= 0) {
+            leases[slot].expires_us = 0;
+        }
+    } else {
+        if (slot < 0) {
+            slot = free_slot;
+        }
+        if (slot >= 0) {
+            snprintf(leases[slot].id, sizeof(leases[slot].id), "%s", viewer_obj->valuestring);
+            leases[slot].expires_us = now + (uint64_t)lease_ms * 1000;
+        } else {
+            fprintf(stderr, "观看者数量超过 %d，忽略 %s\n", PRESENCE_MAX_VIEWERS, viewer_obj->valuestring);
+        }
+    }
+
+    stats.viewers = count_viewers(now);
+    if (before == 0 && stats.viewers > 0) {
+        // 暂停期间第一个观看者到来：记录时刻用于计算恢复耗时，并唤醒采集线程
+        if (suspended && wake_us == 0) {
+            wake_us = now;
+        }
+        pthread_cond_broadcast(&presence_cond);
+        printf("观看者 %s 已连接\n", viewer_obj->valuestring);
+    } else if (before > 0 && stats.viewers == 0) {
+        printf("观看者 %s 已离开\n", viewer_obj->valuestring);
+    }
+    pthread_mutex_unlock(&presence_lock);
+    cJSON_Delete(root);
+}
+
+// 当前是否有观看者
+bool presence_active(void) {
+    bool active;
+    if (!presence_on) {
+        return true;
+    }
+    pthread_mutex_lock(&presence_lock);
+    stats.viewers = count_viewers(now_us());
+    active = stats.viewers > 0;
+    pthread_mutex_unlock(&presence_lock);
+    return active;
+}
+
+// 等待观看者出现
+bool presence_wait(int timeout_ms) {
+    struct timespec deadline;
+    bool active;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&presence_lock);
+    while (!(active = count_viewers(now_us()) > 0)) {
+        if (pthread_cond_timedwait(&presence_cond, &presence_lock, &deadline) != 0) {
+            active = count_viewers(now_us()) > 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&presence_lock);
+    return active;
+}
+
+// 采集线程进入暂停
+void presence_mark_suspended(void) {
+    pthread_mutex_lock(&presence_lock);
+    suspended = true;
+    suspended_at_us = now_us();
+    wake_us = 0;
+    stats.suspends++;
+    pthread_mutex_unlock(&presence_lock);
+    printf("无观看者，暂停解码与推流\n");
+}
+
+// 暂停后的第一帧已入队
+void presence_mark_resumed(void) {
+    uint64_t now = now_us();
+    uint64_t latency;
+
+    pthread_mutex_lock(&presence_lock);
+    if (!suspended) {
+        pthread_mutex_unlock(&presence_lock);
+        return;
+    }
+    latency = now - (wake_us ? wake_us : now);
+    suspended = false;
+    stats.resumes++;
+    stats.idle_us += now - suspended_at_us;
+    stats.last_resume_us = latency;
+    if (latency > stats.max_resume_us) {
+        stats.max_resume_us = latency;
+    }
+    pthread_mutex_unlock(&presence_lock);
+    printf("观看者到来，已恢复推流，恢复耗时 %.1f ms\n", latency / 1000.0);
+}
+
+// 获取统计
+void presence_get_stats(presence_stats_t *out) {
+    pthread_mutex_lock(&presence_lock);
+    stats.viewers = count_viewers(now_us());
+    *out = stats;
+    pthread_mutex_unlock(&presence_lock);
+}
+
+// 打印观看者与暂停统计
+void presence_print_status(void) {
+    presence_stats_t s;
+    if (!presence_on) {
+        return;
+    }
+    presence_get_stats(&s);
+    printf("观看者: %d, 暂停 %llu 次（累计 %.1f s），恢复耗时 最近 %.1f ms / 最大 %.1f ms\n",
+           s.viewers, (unsigned long long)s.suspends, s.idle_us / 1000000.0,
+           s.last_resume_us / 1000.0, s.max_resume_us / 1000.0);
+}
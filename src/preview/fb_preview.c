@@ -0,0 +1,223 @@
+/**
+ * 本地预览：从共享内存帧环读取最新帧，居中显示到 framebuffer
+ * 用法: fb_preview [shm名称] [framebuffer设备]
+ * 与推流进程独立运行，不经过MQTT，读者来不及时直接跳到最新帧。
+ */
+#include "shmring/shmring.h"
+#include "camera/pixfmt.h"
+#include "config/config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/fb.h>
+
+static volatile int g_running = 1;
+
+// framebuffer 设备
+typedef struct {
+    int fd;
+    uint8_t *mem;
+    size_t mem_size;
+    struct fb_var_screeninfo var;
+    struct fb_fix_screeninfo fix;
+} fb_dev_t;
+
+static void sig_handler(int sig) {
+    (void)sig;
+    g_running = 0;
+}
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// 打开并映射 framebuffer，只支持16位和32位
+static int fb_open(fb_dev_t *fb, const char *path) {
+    memset(fb, 0, sizeof(fb_dev_t));
+    fb->fd = open(path, O_RDWR);
+    if (fb->fd < 0) {
+        perror("无法打开framebuffer");
+        return -1;
+    }
+    if (ioctl(fb->fd, FBIOGET_VSCREENINFO, &fb->var) < 0 ||
+        ioctl(fb->fd, FBIOGET_FSCREENINFO, &fb->fix) < 0) {
+        perror("读取framebuffer参数失败");
+        close(fb->fd);
+        return -1;
+    }
+    if (fb->var.bits_per_pixel != 16 && fb->var.bits_per_pixel != 32) {
+        fprintf(stderr, "不支持的framebuffer位深: %u\n", fb->var.bits_per_pixel);
+        close(fb->fd);
+        return -1;
+    }
+    fb->mem_size = fb->fix.smem_len;
+    fb->mem = (uint8_t *)mmap(NULL, fb->mem_size, PROT_READ | PROT_WRITE, MAP_SHARED, fb->fd, 0);
+    if (fb->mem == MAP_FAILED) {
+        perror("framebuffer映射失败");
+        close(fb->fd);
+        return -1;
+    }
+    printf("framebuffer: %s %ux%u %ubpp\n", path, fb->var.xres, fb->var.yres, fb->var.bits_per_pixel);
+    return 0;
+}
+
+static void fb_close(fb_dev_t *fb) {
+    if (fb->mem && fb->mem != MAP_FAILED) {
+        munmap(fb->mem, fb->mem_size);
+    }
+    if (fb->fd >= 0) {
+        close(fb->fd);
+    }
+}
+
+// RGB565（小端）转 RGB888
+static void rgb565_to_rgb(const uint8_t *p, uint8_t rgb[3]) {
+    uint16_t v = (uint16_t)(p[0] | (p[1] << 8));
+    rgb[0] = (uint8_t)(((v >> 11) & 0x1f) * 255 / 31);
+    rgb[1] = (uint8_t)(((v >> 5) & 0x3f) * 255 / 63);
+    rgb[2] = (uint8_t)((v & 0x1f) * 255 / 31);
+}
+
+// 取帧中一个像素的 RGB888 值
+static void pixel_rgb(const shmring_frame_t *frame, const uint8_t *pixels, size_t row_bytes,
+                      int x, int y, uint8_t rgb[3]) {
+    const uint8_t *row = pixels + (size_t)y * row_bytes;
+    switch (frame->pixel_format) {
+    case PIXEL_FORMAT_RGB565:
+        rgb565_to_rgb(row + x * 2, rgb);
+        break;
+    case PIXEL_FORMAT_RGB332:
+        rgb[0] = (uint8_t)((row[x] >> 5) * 255 / 7);
+        rgb[1] = (uint8_t)(((row[x] >> 2) & 7) * 255 / 7);
+        rgb[2] = (uint8_t)((row[x] & 3) * 255 / 3);
+        break;
+    case PIXEL_FORMAT_GRAY4: {
+        uint8_t v = (x & 1) ? (row[x / 2] & 0x0f) : (row[x / 2] >> 4);
+        rgb[0] = rgb[1] = rgb[2] = (uint8_t)(v * 17);
+        break;
+    }
+    case PIXEL_FORMAT_PAL8:
+        memcpy(rgb, frame->data + row[x] * 3, 3);
+        break;
+    default:
+        rgb[0] = rgb[1] = rgb[2] = row[x];
+        break;
+    }
+}
+
+// 按 framebuffer 的颜色分量位置打包
+static uint32_t fb_pack(const fb_dev_t *fb, const uint8_t rgb[3]) {
+    const struct fb_var_screeninfo *v = &fb->var;
+    return ((uint32_t)(rgb[0] >> (8 - v->red.length)) << v->red.offset) |
+           ((uint32_t)(rgb[1] >> (8 - v->green.length)) << v->green.offset) |
+           ((uint32_t)(rgb[2] >> (8 - v->blue.length)) << v->blue.offset);
+}
+
+// 把一帧居中绘制到 framebuffer，超出屏幕的部分裁掉
+// 注视区域编码的帧：外围图像按最近邻放大到整幅画面，注视区域直接覆盖
+static void fb_draw(fb_dev_t *fb, const shmring_frame_t *frame) {
+    const uint8_t *pixels = frame->data + frame->palette_len;
+    bool foveated = frame->roi_width > 0;
+    int src_w = foveated ? frame->periph_width : frame->width;
+    int src_h = foveated ? frame->periph_height : frame->height;
+    size_t row_bytes = pixfmt_row_bytes((pixel_format_t)frame->pixel_format, src_w);
+    const uint8_t *roi = pixels + row_bytes * src_h;
+    size_t roi_bytes = foveated ? (size_t)frame->roi_width * frame->roi_height * 2 : 0;
+    int bytes_pp = fb->var.bits_per_pixel / 8;
+    int w = frame->width < (int)fb->var.xres ? frame->width : (int)fb->var.xres;
+    int h = frame->height < (int)fb->var.yres ? frame->height : (int)fb->var.yres;
+    int x0 = ((int)fb->var.xres - w) / 2 + (int)fb->var.xoffset;
+    int y0 = ((int)fb->var.yres - h) / 2 + (int)fb->var.yoffset;
+
+    // 调色板帧的像素值直接作为调色板下标，调色板不足 256 项时丢弃该帧
+    if (row_bytes * src_h + frame->palette_len + roi_bytes > frame->data_len ||
+        src_w == 0 || src_h == 0 ||
+        (frame->pixel_format == PIXEL_FORMAT_PAL8 && frame->palette_len < PIXFMT_PALETTE_SIZE * 3)) {
+        return;
+    }
+    for (int y = 0; y < h; y++) {
+        uint8_t *dst = fb->mem + (size_t)(y0 + y) * fb->fix.line_length + (size_t)x0 * bytes_pp;
+        int ry = y - frame->roi_y;
+        for (int x = 0; x < w; x++) {
+            uint8_t rgb[3];
+            int rx = x - frame->roi_x;
+            if (foveated && rx >= 0 && rx < frame->roi_width && ry >= 0 && ry < frame->roi_height) {
+                rgb565_to_rgb(roi + ((size_t)ry * frame->roi_width + rx) * 2, rgb);
+            } else if (foveated) {
+                pixel_rgb(frame, pixels, row_bytes, x * src_w / frame->width, y * src_h / frame->height, rgb);
+            } else {
+                pixel_rgb(frame, pixels, row_bytes, x, y, rgb);
+            }
+            uint32_t v = fb_pack(fb, rgb);
+            if (bytes_pp == 2) {
+                ((uint16_t *)dst)[x] = (uint16_t)v;
+            } else {
+                ((uint32_t *)dst)[x] = v;
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const char *shm_name = argc > 1 ? argv[1] : SHMRING_NAME;
+    const char *fb_path = argc > 2 ? argv[2] : PREVIEW_FB_DEVICE;
+    shmring_reader_t reader = { .fd = -1 }; // 打开前收到信号时 shmring_close 不做任何操作
+    shmring_frame_t frame;
+    fb_dev_t fb;
+    uint64_t shown = 0, stale = 0;
+    int64_t age_total = 0;
+
+    signal(SIGINT, sig_handler);
+    signal(SIGTERM, sig_handler);
+
+    if (fb_open(&fb, fb_path) != 0) {
+        return 1;
+    }
+    // 推流进程可能稍后才启动，等待帧环出现
+    while (g_running && shmring_open(&reader, shm_name) != 0) {
+        sleep(1);
+    }
+
+    while (g_running) {
+        if (!shmring_wait(&reader, 1000)) {
+            // 写端重启会重建帧环，长时间无新帧时重新打开
+            if (++stale >= PREVIEW_REOPEN_SEC) {
+                shmring_close(&reader);
+                while (g_running && shmring_open(&reader, shm_name) != 0) {
+                    sleep(1);
+                }
+                stale = 0;
+            }
+            continue;
+        }
+        stale = 0;
+        if (shmring_read_latest(&reader, &frame) != 0) {
+            continue;
+        }
+
+        fb_draw(&fb, &frame);
+        // 绘制期间被覆盖的帧可能撕裂，下一帧会立即覆盖它，只计数不重画
+        if (!shmring_frame_valid(&reader, &frame)) {
+            reader.torn++;
+        }
+        age_total += (int64_t)(now_us() - frame.capture_us);
+        if (++shown % 100 == 0) {
+            printf("预览: 已显示 %llu 帧, 平均帧龄 %lld ms, 跳过 %llu, 覆盖 %llu\n",
+                   (unsigned long long)shown, (long long)(age_total / 100 / 1000),
+                   (unsigned long long)reader.missed, (unsigned long long)reader.torn);
+            age_total = 0;
+        }
+    }
+
+    shmring_close(&reader);
+    fb_close(&fb);
+    return 0;
+}
@@ -0,0 +1,258 @@
+#include "reactor/reactor.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+// 初始化事件循环
+int reactor_init(reactor_ctx *ctx) {
+    memset(ctx, 0, sizeof(reactor_ctx));
+    ctx->epoll_fd = -1;
+    ctx->wakeup_fd = -1;
+
+    ctx->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (ctx->epoll_fd < 0) {
+        perror("epoll创建失败");
+        return -1;
+    }
+
+    ctx->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ctx->wakeup_fd < 0) {
+        perror("eventfd创建失败");
+        close(ctx->epoll_fd);
+        ctx->epoll_fd = -1;
+        return -1;
+    }
+
+    // 唤醒描述符不注册回调，仅用于打断 epoll_wait
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = ctx->wakeup_fd;
+    if (epoll_ctl(ctx->epoll_fd, EPOLL_CTL_ADD, ctx->wakeup_fd, &ev) < 0) {
+        perror("注册唤醒描述符失败");
+        reactor_destroy(ctx);
+        return -1;
+    }
+
+    ctx->running = 1;
+    return 0;
+}
+
+// 注册文件描述符
+int reactor_add(reactor_ctx *ctx, int fd, uint32_t events, reactor_callback cb, void *arg) {
+    struct epoll_event ev;
+
+    if (!ctx || fd < 0 || !cb) {
+        return -1;
+    }
+    if (ctx->handler_count >= REACTOR_MAX_HANDLERS) {
+        fprintf(stderr, "事件循环注册数量已达上限\n");
+        return -1;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(ctx->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        perror("注册文件描述符失败");
+        return -1;
+    }
+
+    ctx->handlers[ctx->handler_count].fd = fd;
+    ctx->handlers[ctx->handler_count].cb = cb;
+    ctx->handlers[ctx->handler_count].arg = arg;
+    ctx->handler_count++;
+    return 0;
+}
+
+// 注销文件描述符
+void reactor_remove(reactor_ctx *ctx, int fd) {
+    for (int i = 0; i < ctx->handler_count; i++) {
+        if (ctx->handlers[i].fd == fd) {
+            epoll_ctl(ctx->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+            ctx->handlers[i] = ctx->handlers[ctx->handler_count - 1];
+            ctx->handler_count--;
+            return;
+        }
+    }
+}
+
+// 运行事件循环：没有事件时线程一直睡眠，不做周期性轮询
+int reactor_run(reactor_ctx *ctx) {
+    struct epoll_event events[REACTOR_MAX_HANDLERS + 1];
+
+    while (ctx->running) {
+        int n = epoll_wait(ctx->epoll_fd, events, REACTOR_MAX_HANDLERS + 1, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait失败");
+            return -1;
+        }
+        ctx->wakeups++;
+
+        for (int i = 0; i < n && ctx->running; i++) {
+            int fd = events[i].data.fd;
+            if (fd == ctx->wakeup_fd) {
+                reactor_drain(fd);
+                continue;
+            }
+            for (int j = 0; j < ctx->handler_count; j++) {
+                if (ctx->handlers[j].fd == fd) {
+                    ctx->handlers[j].cb(fd, events[i].events, ctx->handlers[j].arg);
+                    break;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// 停止事件循环（可在信号处理函数中调用）
+void reactor_stop(reactor_ctx *ctx) {
+    ctx->running = 0;
+    reactor_wakeup(ctx);
+}
+
+// 唤醒事件循环：eventfd 写入是异步信号安全的
+void reactor_wakeup(reactor_ctx *ctx) {
+    uint64_t one = 1;
+    if (ctx->wakeup_fd >= 0) {
+        ssize_t ret = write(ctx->wakeup_fd, &one, sizeof(one));
+        (void)ret;
+    }
+}
+
+// 释放事件循环资源
+void reactor_destroy(reactor_ctx *ctx) {
+    if (ctx->wakeup_fd >= 0) {
+        close(ctx->wakeup_fd);
+        ctx->wakeup_fd = -1;
+    }
+    if (ctx->epoll_fd >= 0) {
+        close(ctx->epoll_fd);
+        ctx->epoll_fd = -1;
+    }
+    ctx->handler_count = 0;
+}
+
+// 创建单次定时器
+int reactor_timer_create(void) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        perror("timerfd创建失败");
+    }
+    return fd;
+}
+
+// 设置单次定时器在 delay_ms 毫秒后到期
+int reactor_timer_arm_ms(int timer_fd, long delay_ms) {
+    struct itimerspec spec;
+
+    memset(&spec, 0, sizeof(spec));
+    if (delay_ms >= 0) {
+        // it_value 全零表示取消定时器，因此0毫秒按1纳秒处理
+        spec.it_value.tv_sec = delay_ms / 1000;
+        spec.it_value.tv_nsec = (delay_ms % 1000) * 1000000;
+        if (delay_ms == 0) {
+            spec.it_value.tv_nsec = 1;
+        }
+    }
+    if (timerfd_settime(timer_fd, 0, &spec, NULL) < 0) {
+        perror("设置定时器失败");
+        return -1;
+    }
+    return 0;
+}
+
+// 读取并清除 timerfd/eventfd 的计数
+uint64_t reactor_drain(int fd) {
+    uint64_t count = 0;
+    if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+        return 0;
+    }
+    return count;
+}
+
+// 以当前时刻为起点设置周期性绝对截止时间
+static int ticker_arm(reactor_ticker_t *ticker) {
+    struct itimerspec spec;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    spec.it_interval.tv_sec = ticker->period_us / 1000000;
+    spec.it_interval.tv_nsec = (ticker->period_us % 1000000) * 1000;
+    spec.it_value.tv_sec = now.tv_sec + spec.it_interval.tv_sec;
+    spec.it_value.tv_nsec = now.tv_nsec + spec.it_interval.tv_nsec;
+    if (spec.it_value.tv_nsec >= 1000000000) {
+        spec.it_value.tv_sec++;
+        spec.it_value.tv_nsec -= 1000000000;
+    }
+
+    // TFD_TIMER_ABSTIME：后续截止时间由内核按固定网格推进，不受处理耗时影响
+    if (timerfd_settime(ticker->fd, TFD_TIMER_ABSTIME, &spec, NULL) < 0) {
+        perror("设置周期定时器失败");
+        return -1;
+    }
+    return 0;
+}
+
+// 初始化周期定时器
+int reactor_ticker_init(reactor_ticker_t *ticker, long period_us) {
+    memset(ticker, 0, sizeof(reactor_ticker_t));
+    if (period_us <= 0) {
+        ticker->fd = -1;
+        return -1;
+    }
+    ticker->period_us = period_us;
+
+    // 阻塞模式：reactor_ticker_wait 在 read 上睡眠直到截止时间
+    ticker->fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (ticker->fd < 0) {
+        perror("timerfd创建失败");
+        return -1;
+    }
+    if (ticker_arm(ticker) != 0) {
+        reactor_ticker_close(ticker);
+        return -1;
+    }
+    return 0;
+}
+
+// 修改周期定时器的周期
+int reactor_ticker_set_period(reactor_ticker_t *ticker, long period_us) {
+    if (ticker->fd < 0 || period_us <= 0) {
+        return -1;
+    }
+    ticker->period_us = period_us;
+    return ticker_arm(ticker);
+}
+
+// 阻塞等待下一个截止时间
+uint64_t reactor_ticker_wait(reactor_ticker_t *ticker) {
+    uint64_t expirations = 0;
+
+    while (read(ticker->fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        if (errno != EINTR) {
+            perror("读取周期定时器失败");
+            return 0;
+        }
+    }
+    ticker->ticks += expirations;
+    if (expirations > 1) {
+        ticker->missed += expirations - 1;
+    }
+    return expirations;
+}
+
+// 关闭周期定时器
+void reactor_ticker_close(reactor_ticker_t *ticker) {
+    if (ticker->fd >= 0) {
+        close(ticker->fd);
+        ticker->fd = -1;
+    }
+}
@@ -0,0 +1,647 @@
+#include "recorder/recorder.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+// 内存索引项，对应文件中的一个槽位
+typedef struct {
+    int valid;             // 1-槽位数据完整可读
+    uint32_t frame_id;     // 帧ID
+    uint32_t payload_len;  // frame_header_t + recorder_layout_t + 图像数据长度
+    uint64_t seq;          // 写入序号
+    uint64_t timestamp_ms; // 采集时间戳
+} slot_index_t;
+
+// 录像相关全局变量
+static recorder_config_t rec_cfg;
+static int rec_fd = -1;
+static bool rec_running = false;
+static slot_index_t *rec_index = NULL;   // 槽位索引
+static uint32_t rec_next_slot = 0;       // 下一个写入槽位
+static uint64_t rec_next_seq = 1;        // 下一个写入序号
+static uint64_t rec_session_seq = 1;     // 本次运行写入的第一个序号（帧ID每次启动从0开始，只在本次运行中按帧ID查找）
+static recorder_stats_t rec_stats;
+
+// 待写队列：缓冲区按先进先出循环使用，第 i 个待写项使用 (q_head + i) % depth 号缓冲区
+static unsigned char **q_bufs = NULL;
+static uint32_t *q_slots = NULL;
+static int q_head = 0;
+static int q_count = 0;
+
+static pthread_mutex_t rec_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rec_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t writer_tid;
+
+// 回放线程状态
+static pthread_t replay_tid;
+static bool replay_started = false;
+static volatile int replay_active = 0;
+
+// CRC32（IEEE 802.3，反射多项式 0xEDB88320）查表，首次使用时生成
+static uint32_t crc_table[256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void crc_table_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[i] = c;
+    }
+}
+
+// 累加计算 CRC32，首次调用时 crc 传 0
+static uint32_t crc32_update(uint32_t crc, const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    crc = ~crc;
+    while (len--) {
+        crc = crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// 计算槽位校验值：记录头中 crc 之前的字段 + 记录内容
+static uint32_t slot_crc(const recorder_slot_header_t *sh, const void *payload) {
+    uint32_t crc = crc32_update(0, sh, offsetof(recorder_slot_header_t, crc));
+    return crc32_update(crc, payload, sh->payload_len);
+}
+
+// 计算槽位在文件中的偏移
+static off_t slot_offset(uint32_t slot) {
+    return (off_t)RECORDER_FILE_HEADER_SIZE + (off_t)slot * rec_cfg.slot_size;
+}
+
+// 获取当前墙钟时间（毫秒），用于按时间查找
+static uint64_t realtime_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// 新建环形文件：写入文件头并一次性预分配全部空间，避免运行中扩展文件
+static int create_ring_file(void) {
+    recorder_file_header_t header;
+    off_t total = slot_offset(rec_cfg.slot_count);
+    int ret;
+
+    // 清空旧内容，确保旧槽位不会被误认为有效数据
+    if (ftruncate(rec_fd, 0) < 0) {
+        perror("录像文件截断失败");
+        return -1;
+    }
+    ret = posix_fallocate(rec_fd, 0, total);
+    if (ret != 0) {
+        fprintf(stderr, "录像文件预分配失败: %s\n", strerror(ret));
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic = RECORDER_FILE_MAGIC;
+    header.version = RECORDER_VERSION;
+    header.slot_count = rec_cfg.slot_count;
+    header.slot_size = rec_cfg.slot_size;
+    if (pwrite(rec_fd, &header, sizeof(header), 0) != sizeof(header)) {
+        perror("录像文件头写入失败");
+        return -1;
+    }
+    fdatasync(rec_fd);
+    printf("已创建录像文件: %s (%u 槽位 x %u 字节)\n",
+           rec_cfg.path, rec_cfg.slot_count, rec_cfg.slot_size);
+    return 0;
+}
+
+// 从已有文件的槽位重建内存索引，并恢复写入位置
+// 逐个读出记录内容校验 CRC：断电时批量写入只落盘了一部分的槽位（新记录头配旧数据或零）不会被回放
+static void rebuild_index(void) {
+    recorder_slot_header_t sh;
+    uint64_t max_seq = 0;
+    uint32_t newest = 0;
+    uint32_t valid = 0;
+    uint32_t torn = 0;
+    unsigned char *payload = malloc(rec_cfg.slot_size - sizeof(sh));
+
+    if (!payload) {
+        fprintf(stderr, "录像索引内存分配失败，忽略已有录像\n");
+    }
+    for (uint32_t i = 0; payload && i < rec_cfg.slot_count; i++) {
+        frame_header_t fh;
+        rec_index[i].valid = 0;
+        if (pread(rec_fd, &sh, sizeof(sh), slot_offset(i)) != sizeof(sh) ||
+            sh.magic != RECORDER_SLOT_MAGIC ||
+            sh.payload_len < sizeof(frame_header_t) + sizeof(recorder_layout_t) ||
+            sh.payload_len > rec_cfg.slot_size - sizeof(sh)) {
+            continue;
+        }
+        if (pread(rec_fd, payload, sh.payload_len, slot_offset(i) + sizeof(sh)) != (ssize_t)sh.payload_len) {
+            continue;
+        }
+        if (slot_crc(&sh, payload) != sh.crc) {
+            torn++;
+            continue;
+        }
+        memcpy(&fh, payload, sizeof(fh));
+        rec_index[i].valid = 1;
+        rec_index[i].frame_id = fh.frame_id;
+        rec_index[i].payload_len = sh.payload_len;
+        rec_index[i].seq = sh.seq;
+        rec_index[i].timestamp_ms = sh.timestamp_ms;
+        valid++;
+        if (sh.seq > max_seq) {
+            max_seq = sh.seq;
+            newest = i;
+        }
+    }
+
+    free(payload);
+
+    if (valid > 0) {
+        rec_next_slot = (newest + 1) % rec_cfg.slot_count;
+        rec_next_seq = max_seq + 1;
+    }
+    printf("录像索引已恢复: %u 帧有效，%u 帧校验失败，写入位置 %u\n", valid, torn, rec_next_slot);
+}
+
+// 打开环形文件，几何参数不一致时重新创建
+static int open_ring_file(void) {
+    recorder_file_header_t header;
+
+    rec_fd = open(rec_cfg.path, O_RDWR | O_CREAT, 0644);
+    if (rec_fd < 0) {
+        perror("无法打开录像文件");
+        return -1;
+    }
+
+    if (pread(rec_fd, &header, sizeof(header), 0) == sizeof(header) &&
+        header.magic == RECORDER_FILE_MAGIC &&
+        header.version == RECORDER_VERSION &&
+        header.slot_count == rec_cfg.slot_count &&
+        header.slot_size == rec_cfg.slot_size) {
+        rebuild_index();
+        return 0;
+    }
+    return create_ring_file();
+}
+
+// 将一批连续槽位合并为一次 pwritev，遇到环形回绕时拆分
+static int write_batch(int first, int n) {
+    struct iovec iov[n];
+    int run_start = 0;
+
+    for (int i = 0; i < n; i++) {
+        int buf = (first + i) % rec_cfg.queue_depth;
+        recorder_slot_header_t *sh = (recorder_slot_header_t *)q_bufs[buf];
+        // 校验值在写线程中计算，不占用采集线程的时间
+        sh->crc = slot_crc(sh, q_bufs[buf] + sizeof(*sh));
+        iov[i].iov_base = q_bufs[buf];
+        iov[i].iov_len = rec_cfg.slot_size;
+
+        bool last = (i == n - 1);
+        bool contiguous = !last &&
+            q_slots[(first + i + 1) % rec_cfg.queue_depth] == q_slots[buf] + 1;
+        if (!contiguous) {
+            int start_buf = (first + run_start) % rec_cfg.queue_depth;
+            off_t offset = slot_offset(q_slots[start_buf]);
+            ssize_t expect = (ssize_t)(i - run_start + 1) * rec_cfg.slot_size;
+            ssize_t ret = pwritev(rec_fd, &iov[run_start], i - run_start + 1, offset);
+            if (ret != expect) {
+                perror("录像写入失败");
+                return -1;
+            }
+            // 提前触发回写，避免脏页堆积后集中刷盘造成长时间停顿
+            sync_file_range(rec_fd, offset, expect, SYNC_FILE_RANGE_WRITE);
+            run_start = i + 1;
+        }
+    }
+    return 0;
+}
+
+// 后台写线程：攒够一批或超时后批量写入
+static void *writer_thread(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&rec_lock);
+    while (rec_running || q_count > 0) {
+        if (rec_running && q_count < rec_cfg.batch) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_sec += rec_cfg.flush_ms / 1000;
+            deadline.tv_nsec += (long)(rec_cfg.flush_ms % 1000) * 1000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            int ret = 0;
+            while (rec_running && q_count < rec_cfg.batch && ret != ETIMEDOUT) {
+                ret = pthread_cond_timedwait(&rec_cond, &rec_lock, &deadline);
+            }
+            if (q_count == 0) {
+                continue;
+            }
+        }
+
+        int first = q_head;
+        int n = q_count < rec_cfg.batch ? q_count : rec_cfg.batch;
+        pthread_mutex_unlock(&rec_lock);
+
+        // 文件写入在锁外进行，采集线程可继续向其余缓冲区追加
+        int ret = write_batch(first, n);
+
+        pthread_mutex_lock(&rec_lock);
+        for (int i = 0; i < n; i++) {
+            int buf = (first + i) % rec_cfg.queue_depth;
+            recorder_slot_header_t *sh = (recorder_slot_header_t *)q_bufs[buf];
+            frame_header_t *fh = (frame_header_t *)(q_bufs[buf] + sizeof(*sh));
+            slot_index_t *entry = &rec_index[q_slots[buf]];
+            // 槽位在入队时已被标记无效；写入失败则保持无效
+            if (ret == 0 && entry->seq == sh->seq) {
+                entry->valid = 1;
+                entry->frame_id = fh->frame_id;
+                entry->payload_len = sh->payload_len;
+                entry->timestamp_ms = sh->timestamp_ms;
+                rec_stats.written++;
+            }
+        }
+        q_head = (q_head + n) % rec_cfg.queue_depth;
+        q_count -= n;
+        rec_stats.batches++;
+    }
+    pthread_mutex_unlock(&rec_lock);
+    return NULL;
+}
+
+// 打开（必要时创建并预分配）环形文件，启动后台写线程
+int recorder_init(const recorder_config_t *config) {
+    pthread_condattr_t attr;
+
+    if (!config || !config->path || config->slot_count == 0 || config->batch <= 0 ||
+        config->queue_depth < config->batch ||
+        config->slot_size <= sizeof(recorder_slot_header_t) + sizeof(frame_header_t) + sizeof(recorder_layout_t)) {
+        fprintf(stderr, "录像配置无效\n");
+        return -1;
+    }
+    if (rec_running) {
+        recorder_close();
+    }
+
+    pthread_once(&crc_once, crc_table_init);
+    rec_cfg = *config;
+    memset(&rec_stats, 0, sizeof(rec_stats));
+    rec_next_slot = 0;
+    rec_next_seq = 1;
+    q_head = 0;
+    q_count = 0;
+
+    rec_index = calloc(rec_cfg.slot_count, sizeof(slot_index_t));
+    q_bufs = calloc(rec_cfg.queue_depth, sizeof(unsigned char *));
+    q_slots = calloc(rec_cfg.queue_depth, sizeof(uint32_t));
+    if (!rec_index || !q_bufs || !q_slots) {
+        fprintf(stderr, "录像索引内存分配失败\n");
+        recorder_close();
+        return -1;
+    }
+    // 暂存缓冲区在启动时一次性分配，运行中不再申请内存
+    for (int i = 0; i < rec_cfg.queue_depth; i++) {
+        q_bufs[i] = calloc(1, rec_cfg.slot_size);
+        if (!q_bufs[i]) {
+            fprintf(stderr, "录像缓冲区内存分配失败\n");
+            recorder_close();
+            return -1;
+        }
+    }
+
+    if (open_ring_file() != 0) {
+        recorder_close();
+        return -1;
+    }
+    rec_session_seq = rec_next_seq;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&rec_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    rec_running = true;
+    if (pthread_create(&writer_tid, NULL, writer_thread, NULL) != 0) {
+        fprintf(stderr, "录像写线程创建失败\n");
+        rec_running = false;
+        pthread_cond_destroy(&rec_cond);
+        recorder_close();
+        return -1;
+    }
+    return 0;
+}
+
+// 追加一帧到写队列，不会等待文件系统
+int recorder_append(const frame_header_t *header, const frame_layout_t *layout, const void *data) {
+    size_t total;
+
+    if (!header || !layout || !data) {
+        return -1;
+    }
+    total = sizeof(recorder_slot_header_t) + sizeof(frame_header_t) + sizeof(recorder_layout_t) +
+            header->frame_len;
+
+    pthread_mutex_lock(&rec_lock);
+    if (!rec_running) {
+        pthread_mutex_unlock(&rec_lock);
+        return -1;
+    }
+    if (total > rec_cfg.slot_size || q_count >= rec_cfg.queue_depth) {
+        rec_stats.dropped++;
+        pthread_mutex_unlock(&rec_lock);
+        return -2;
+    }
+
+    int buf = (q_head + q_count) % rec_cfg.queue_depth;
+    uint32_t slot = rec_next_slot;
+    recorder_slot_header_t *sh = (recorder_slot_header_t *)q_bufs[buf];
+    recorder_layout_t rl = {
+        .width = layout->width,
+        .height = layout->height,
+        .pixel_format = layout->pixel_format,
+        .flags = layout->flags,
+        .palette_len = layout->palette_len,
+        .roi = layout->roi,
+    };
+    unsigned char *p = q_bufs[buf] + sizeof(*sh);
+    sh->magic = RECORDER_SLOT_MAGIC;
+    sh->payload_len = sizeof(frame_header_t) + sizeof(recorder_layout_t) + header->frame_len;
+    sh->seq = rec_next_seq++;
+    sh->timestamp_ms = realtime_ms();
+    memcpy(p, header, sizeof(frame_header_t));
+    memcpy(p + sizeof(frame_header_t), &rl, sizeof(rl));
+    memcpy(p + sizeof(frame_header_t) + sizeof(rl), data, header->frame_len);
+
+    // 预留槽位：旧数据即将被覆盖，立即从索引中移除
+    rec_index[slot].valid = 0;
+    rec_index[slot].seq = sh->seq;
+    q_slots[buf] = slot;
+    rec_next_slot = (slot + 1) % rec_cfg.slot_count;
+    q_count++;
+    rec_stats.appended++;
+
+    if (q_count >= rec_cfg.batch) {
+        pthread_cond_signal(&rec_cond);
+    }
+    pthread_mutex_unlock(&rec_lock);
+    return 0;
+}
+
+// 在索引中查找帧：返回满足条件且写入序号最小（最旧）的槽位
+// 帧ID每次启动从0开始，按帧ID查找时跳过之前运行写入的槽位；按时间查找不受限制
+int recorder_find(recorder_seek_t mode, uint64_t key) {
+    int found = -1;
+    uint64_t best_seq = UINT64_MAX;
+
+    pthread_mutex_lock(&rec_lock);
+    if (rec_index) {
+        for (uint32_t i = 0; i < rec_cfg.slot_count; i++) {
+            const slot_index_t *entry = &rec_index[i];
+            if (!entry->valid || (mode == RECORDER_SEEK_FRAME_ID && entry->seq < rec_session_seq)) {
+                continue;
+            }
+            uint64_t value = (mode == RECORDER_SEEK_TIME) ? entry->timestamp_ms : entry->frame_id;
+            if (value >= key && entry->seq < best_seq) {
+                best_seq = entry->seq;
+                found = (int)i;
+            }
+        }
+    }
+    pthread_mutex_unlock(&rec_lock);
+    return found;
+}
+
+// 读取槽位中的帧（frame_header_t + recorder_layout_t + 图像数据）
+int recorder_read(int slot, unsigned char **buffer, long *size, uint64_t *timestamp_ms) {
+    slot_index_t entry;
+
+    if (!buffer || !size || slot < 0) {
+        return -1;
+    }
+    *buffer = NULL;
+    *size = 0;
+
+    pthread_mutex_lock(&rec_lock);
+    if (!rec_index || (uint32_t)slot >= rec_cfg.slot_count || !rec_index[slot].valid) {
+        pthread_mutex_unlock(&rec_lock);
+        return -1;
+    }
+    entry = rec_index[slot];
+    pthread_mutex_unlock(&rec_lock);
+
+    *buffer = (unsigned char *)malloc(entry.payload_len);
+    if (!*buffer) {
+        fprintf(stderr, "内存分配失败\n");
+        return -1;
+    }
+    if (pread(rec_fd, *buffer, entry.payload_len,
+              slot_offset(slot) + sizeof(recorder_slot_header_t)) != (ssize_t)entry.payload_len) {
+        perror("录像读取失败");
+        free(*buffer);
+        *buffer = NULL;
+        return -1;
+    }
+
+    // 读取期间槽位若被重新预留覆盖，则数据不可信
+    pthread_mutex_lock(&rec_lock);
+    bool intact = rec_index[slot].valid && rec_index[slot].seq == entry.seq;
+    pthread_mutex_unlock(&rec_lock);
+    if (!intact) {
+        free(*buffer);
+        *buffer = NULL;
+        return -2;
+    }
+
+    *size = entry.payload_len;
+    if (timestamp_ms) {
+        *timestamp_ms = entry.timestamp_ms;
+    }
+    return 0;
+}
+
+// 回放线程参数
+typedef struct {
+    int slot;
+    int count;
+} replay_args_t;
+
+static replay_args_t replay_args;
+
+// 解析一条录像记录并按实时推流的帧头格式发布
+static int publish_record(const unsigned char *buffer, long size) {
+    frame_header_t header;
+    recorder_layout_t rl;
+    size_t meta = sizeof(header) + sizeof(rl);
+
+    if (size < (long)meta) {
+        return -1;
+    }
+    memcpy(&header, buffer, sizeof(header));
+    memcpy(&rl, buffer + sizeof(header), sizeof(rl));
+    if (header.frame_len != (uint32_t)(size - (long)meta) || rl.palette_len > header.frame_len) {
+        fprintf(stderr, "录像记录长度不一致，帧ID: %u\n", header.frame_id);
+        return -1;
+    }
+
+    frame_layout_t layout = {
+        .width = rl.width,
+        .height = rl.height,
+        .pixel_format = rl.pixel_format,
+        .flags = rl.flags,
+        .palette = NULL,
+        .palette_len = rl.palette_len,
+        .roi = rl.roi,
+    };
+    return rec_cfg.replay_publish(&header, &layout, buffer + meta, (long)header.frame_len);
+}
+
+// 回放线程：按原始时间间隔依次发布录像帧，直到追上写入位置
+static void *replay_thread(void *arg) {
+    replay_args_t *args = (replay_args_t *)arg;
+    int slot = args->slot;
+    int sent = 0;
+    uint64_t prev_seq = 0;
+    uint64_t prev_ts = 0;
+
+    printf("开始回放录像，起始槽位: %d\n", slot);
+    while (rec_running && (args->count == 0 || sent < args->count)) {
+        unsigned char *buffer = NULL;
+        long size = 0;
+        uint64_t ts = 0;
+
+        pthread_mutex_lock(&rec_lock);
+        bool valid = rec_index[slot].valid && rec_index[slot].seq > prev_seq;
+        uint64_t seq = rec_index[slot].seq;
+        pthread_mutex_unlock(&rec_lock);
+        // 序号不再递增说明已越过最新帧
+        if (!valid) {
+            break;
+        }
+        if (recorder_read(slot, &buffer, &size, &ts) != 0) {
+            break;
+        }
+
+        // 保持原始帧间隔，间隔异常时限制在1秒以内
+        if (prev_ts != 0 && ts > prev_ts) {
+            uint64_t gap = ts - prev_ts;
+            usleep((useconds_t)((gap > 1000 ? 1000 : gap) * 1000));
+        }
+        if (publish_record(buffer, size) != 0) {
+            fprintf(stderr, "录像回放发布失败\n");
+        }
+        free(buffer);
+
+        prev_seq = seq;
+        prev_ts = ts;
+        sent++;
+        slot = (slot + 1) % rec_cfg.slot_count;
+    }
+    printf("录像回放结束，共发布 %d 帧\n", sent);
+    replay_active = 0;
+    return NULL;
+}
+
+// 启动后台回放
+int recorder_replay_start(recorder_seek_t mode, uint64_t key, int count) {
+    if (!rec_running || !rec_cfg.replay_publish) {
+        fprintf(stderr, "录像未启用，无法回放\n");
+        return -1;
+    }
+    if (count < 0) {
+        fprintf(stderr, "回放帧数无效: %d\n", count);
+        return -1;
+    }
+    if (replay_active) {
+        fprintf(stderr, "已有回放正在进行\n");
+        return -2;
+    }
+
+    int slot = recorder_find(mode, key);
+    if (slot < 0) {
+        fprintf(stderr, "未找到匹配的录像帧\n");
+        return -3;
+    }
+
+    // 回收上一次已结束的回放线程
+    if (replay_started) {
+        pthread_join(replay_tid, NULL);
+        replay_started = false;
+    }
+
+    replay_args.slot = slot;
+    replay_args.count = count;
+    replay_active = 1;
+    if (pthread_create(&replay_tid, NULL, replay_thread, &replay_args) != 0) {
+        fprintf(stderr, "回放线程创建失败\n");
+        replay_active = 0;
+        return -1;
+    }
+    replay_started = true;
+    return 0;
+}
+
+// 获取统计信息
+void recorder_get_stats(recorder_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+    pthread_mutex_lock(&rec_lock);
+    *stats = rec_stats;
+    stats->valid_slots = 0;
+    if (rec_index) {
+        for (uint32_t i = 0; i < rec_cfg.slot_count; i++) {
+            stats->valid_slots += rec_index[i].valid ? 1 : 0;
+        }
+    }
+    pthread_mutex_unlock(&rec_lock);
+}
+
+// 刷新剩余数据，停止写线程并关闭文件
+void recorder_close(void) {
+    bool was_running;
+
+    pthread_mutex_lock(&rec_lock);
+    was_running = rec_running;
+    rec_running = false;
+    pthread_cond_signal(&rec_cond);
+    pthread_mutex_unlock(&rec_lock);
+
+    if (was_running) {
+        // 写线程会在退出前写完队列中剩余的帧
+        pthread_join(writer_tid, NULL);
+        pthread_cond_destroy(&rec_cond);
+    }
+    if (replay_started) {
+        pthread_join(replay_tid, NULL);
+        replay_started = false;
+    }
+
+    if (rec_fd >= 0) {
+        fdatasync(rec_fd);
+        close(rec_fd);
+        rec_fd = -1;
+    }
+    if (q_bufs) {
+        for (int i = 0; i < rec_cfg.queue_depth; i++) {
+            free(q_bufs[i]);
+        }
+        free(q_bufs);
+        q_bufs = NULL;
+    }
+    free(q_slots);
+    q_slots = NULL;
+    free(rec_index);
+    rec_index = NULL;
+
+    if (was_running) {
+        printf("录像已关闭: 写入 %llu 帧，丢弃 %llu 帧\n",
+               (unsigned long long)rec_stats.written, (unsigned long long)rec_stats.dropped);
+    }
+}
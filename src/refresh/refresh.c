@@ -0,0 +1,109 @@
+#include "refresh/refresh.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+// 最近发布的帧ID，按 frame_id % REFRESH_HISTORY 存放；槽位值等于帧ID表示该帧已发布
+static uint32_t history[REFRESH_HISTORY];
+static bool history_used[REFRESH_HISTORY];
+static uint32_t latest_id = 0;
+static bool any_published = false;
+static bool refresh_pending = false;
+static uint64_t last_refresh_us = 0;
+static refresh_stats_t stats;
+static pthread_mutex_t refresh_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// 一帧已成功发布
+void refresh_note_published(uint32_t frame_id) {
+    size_t slot = frame_id % REFRESH_HISTORY;
+
+    pthread_mutex_lock(&refresh_lock);
+    history[slot] = frame_id;
+    history_used[slot] = true;
+    latest_id = frame_id;
+    any_published = true;
+    stats.published++;
+    pthread_mutex_unlock(&refresh_lock);
+}
+
+// 处理刷新请求：统计缺失范围，登记刷新
+void refresh_request(bool has_range, uint32_t first, uint32_t last) {
+    uint64_t lost = 0, dropped = 0, unknown = 0;
+
+    pthread_mutex_lock(&refresh_lock);
+    stats.requests++;
+    // 只统计不晚于最新发布帧的缺口，过大的范围视为无效（frame_id 按32位回绕比较）
+    if (has_range && any_published && (int32_t)(last - first) >= 0 &&
+        (int32_t)(latest_id - last) >= 0 && last - first < 0x10000) {
+        for (uint32_t id = first; ; id++) {
+            size_t slot = id % REFRESH_HISTORY;
+            if (latest_id - id >= REFRESH_HISTORY) {
+                unknown++;
+            } else if (history_used[slot] && history[slot] == id) {
+                lost++;
+            } else {
+                dropped++;
+            }
+            if (id == last) {
+                break;
+            }
+        }
+        stats.net_lost += lost;
+        stats.local_dropped += dropped;
+        stats.unknown += unknown;
+    }
+
+    // 多个接收端同时请求时合并为一次刷新
+    uint64_t now = now_us();
+    if (now - last_refresh_us >= (uint64_t)REFRESH_MIN_INTERVAL_MS * 1000) {
+        refresh_pending = true;
+        last_refresh_us = now;
+    }
+    pthread_mutex_unlock(&refresh_lock);
+
+    if (has_range) {
+        printf("收到刷新请求: 缺失帧 %u~%u（网络丢失 %llu，设备丢弃 %llu，无法区分 %llu）\n", first, last,
+               (unsigned long long)lost, (unsigned long long)dropped, (unsigned long long)unknown);
+    }
+}
+
+// 取出待处理的刷新请求
+bool refresh_take(void) {
+    bool pending;
+
+    pthread_mutex_lock(&refresh_lock);
+    pending = refresh_pending;
+    if (pending) {
+        refresh_pending = false;
+        stats.refreshes++;
+    }
+    pthread_mutex_unlock(&refresh_lock);
+    return pending;
+}
+
+// 获取统计
+void refresh_get_stats(refresh_stats_t *out) {
+    pthread_mutex_lock(&refresh_lock);
+    *out = stats;
+    pthread_mutex_unlock(&refresh_lock);
+}
+
+// 打印丢帧统计
+void refresh_print_status(void) {
+    refresh_stats_t snapshot;
+
+    refresh_get_stats(&snapshot);
+    printf("视频丢帧: 已发布 %llu 帧，网络丢失 %llu (%.2f%%)，设备丢弃 %llu，无法区分 %llu，"
+           "刷新请求 %llu，刷新帧 %llu\n",
+           (unsigned long long)snapshot.published, (unsigned long long)snapshot.net_lost,
+           snapshot.published ? snapshot.net_lost * 100.0 / snapshot.published : 0.0,
+           (unsigned long long)snapshot.local_dropped, (unsigned long long)snapshot.unknown,
+           (unsigned long long)snapshot.requests, (unsigned long long)snapshot.refreshes);
+}
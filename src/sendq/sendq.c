@@ -0,0 +1,210 @@
+#include "sendq/sendq.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+// 发送队列相关全局变量（单生产者：采集线程；单消费者：发布线程）
+static sendq_item_t *q_items = NULL;
+static int q_depth = 0;
+static int q_head = 0;
+static int q_count = 0;
+static uint64_t q_deadline_us = 0;
+static bool q_closed = false;
+static sendq_stats_t q_stats;
+
+static pthread_mutex_t q_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t q_cond = PTHREAD_COND_INITIALIZER;
+
+static const char *drop_reason_names[SENDQ_DROP_REASON_COUNT] = {
+    "overflow", "expired", "late", "send_failed", "offline"
+};
+
+// 获取 CLOCK_MONOTONIC 微秒时间戳
+uint64_t sendq_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// 获取丢帧原因名称
+const char *sendq_drop_reason_name(sendq_drop_reason_t reason) {
+    if (reason < 0 || reason >= SENDQ_DROP_REASON_COUNT) {
+        return "unknown";
+    }
+    return drop_reason_names[reason];
+}
+
+// 丢弃队首帧（需持有锁）
+static void drop_head(sendq_drop_reason_t reason) {
+    sendq_item_t *item = &q_items[q_head];
+    free(item->data);
+    item->data = NULL;
+    q_head = (q_head + 1) % q_depth;
+    q_count--;
+    q_stats.dropped[reason]++;
+}
+
+// 初始化发送队列
+int sendq_init(int depth, long deadline_ms) {
+    if (depth <= 0 || deadline_ms <= 0) {
+        fprintf(stderr, "发送队列参数无效\n");
+        return -1;
+    }
+
+    q_items = (sendq_item_t *)calloc(depth, sizeof(sendq_item_t));
+    if (!q_items) {
+        fprintf(stderr, "发送队列内存分配失败\n");
+        return -1;
+    }
+    q_depth = depth;
+    q_head = 0;
+    q_count = 0;
+    q_deadline_us = (uint64_t)deadline_ms * 1000;
+    q_closed = false;
+    memset(&q_stats, 0, sizeof(q_stats));
+    return 0;
+}
+
+// 帧入队，队列满时挤出最旧的帧
+int sendq_push(const frame_header_t *header, const frame_layout_t *layout,
+               unsigned char *data, long size, uint64_t capture_us) {
+    pthread_mutex_lock(&q_lock);
+    if (q_closed || !q_items) {
+        pthread_mutex_unlock(&q_lock);
+        free(data);
+        return -1;
+    }
+
+    if (q_count == q_depth) {
+        drop_head(SENDQ_DROP_OVERFLOW);
+    }
+
+    sendq_item_t *item = &q_items[(q_head + q_count) % q_depth];
+    item->header = *header;
+    item->layout = *layout;
+    item->data = data;
+    item->size = size;
+    item->capture_us = capture_us;
+    item->deadline_us = capture_us + q_deadline_us;
+    q_count++;
+    q_stats.pushed++;
+
+    pthread_cond_signal(&q_cond);
+    pthread_mutex_unlock(&q_lock);
+    return 0;
+}
+
+// 取出下一帧可发送的帧
+int sendq_pop(sendq_item_t *item) {
+    pthread_mutex_lock(&q_lock);
+    while (!q_closed && q_count == 0) {
+        pthread_cond_wait(&q_cond, &q_lock);
+    }
+    if (q_closed) {
+        pthread_mutex_unlock(&q_lock);
+        return -1;
+    }
+
+    // 有更新的帧可替代时，丢弃已过期或预计迟到的旧帧
+    uint64_t now = sendq_now_us();
+    while (q_count > 1) {
+        const sendq_item_t *head = &q_items[q_head];
+        if (now > head->deadline_us) {
+            drop_head(SENDQ_DROP_EXPIRED);
+        } else if (now + q_stats.est_send_us > head->deadline_us) {
+            drop_head(SENDQ_DROP_LATE);
+        } else {
+            break;
+        }
+    }
+
+    *item = q_items[q_head];
+    q_items[q_head].data = NULL;
+    q_head = (q_head + 1) % q_depth;
+    q_count--;
+    pthread_mutex_unlock(&q_lock);
+    return 0;
+}
+
+// 报告一帧的发送结果
+void sendq_report(const sendq_item_t *item, uint64_t send_us, bool ok) {
+    uint64_t now = sendq_now_us();
+
+    pthread_mutex_lock(&q_lock);
+    if (ok) {
+        q_stats.sent++;
+        if (now > item->deadline_us) {
+            q_stats.sent_late++;
+        }
+        q_stats.last_latency_us = now - item->capture_us;
+        // 指数加权平均估计发送耗时（权重1/8），首帧直接取实测值
+        if (q_stats.est_send_us == 0) {
+            q_stats.est_send_us = send_us;
+        } else {
+            q_stats.est_send_us = (q_stats.est_send_us * 7 + send_us) / 8;
+        }
+    } else {
+        q_stats.dropped[SENDQ_DROP_SEND_FAILED]++;
+    }
+    pthread_mutex_unlock(&q_lock);
+}
+
+// 记录一帧出队后被丢弃
+void sendq_report_drop(sendq_drop_reason_t reason) {
+    if (reason < 0 || reason >= SENDQ_DROP_REASON_COUNT) {
+        return;
+    }
+    pthread_mutex_lock(&q_lock);
+    q_stats.dropped[reason]++;
+    pthread_mutex_unlock(&q_lock);
+}
+
+// 获取统计信息
+void sendq_get_stats(sendq_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+    pthread_mutex_lock(&q_lock);
+    *stats = q_stats;
+    pthread_mutex_unlock(&q_lock);
+}
+
+// 打印统计信息
+void sendq_print_stats(void) {
+    sendq_stats_t stats;
+    sendq_get_stats(&stats);
+    printf("发送队列: 入队 %llu, 发送 %llu (迟到 %llu), 估计发送耗时 %llu ms, 最近延迟 %llu ms\n",
+           (unsigned long long)stats.pushed, (unsigned long long)stats.sent,
+           (unsigned long long)stats.sent_late,
+           (unsigned long long)(stats.est_send_us / 1000),
+           (unsigned long long)(stats.last_latency_us / 1000));
+    printf("发送队列丢帧:");
+    for (int i = 0; i < SENDQ_DROP_REASON_COUNT; i++) {
+        printf(" %s=%llu", drop_reason_names[i], (unsigned long long)stats.dropped[i]);
+    }
+    printf("\n");
+}
+
+// 关闭队列，唤醒阻塞在 sendq_pop 的线程
+void sendq_shutdown(void) {
+    pthread_mutex_lock(&q_lock);
+    q_closed = true;
+    pthread_cond_broadcast(&q_cond);
+    pthread_mutex_unlock(&q_lock);
+}
+
+// 释放队列中剩余的帧
+void sendq_destroy(void) {
+    pthread_mutex_lock(&q_lock);
+    while (q_items && q_count > 0) {
+        free(q_items[q_head].data);
+        q_items[q_head].data = NULL;
+        q_head = (q_head + 1) % q_depth;
+        q_count--;
+    }
+    free(q_items);
+    q_items = NULL;
+    q_closed = true;
+    pthread_mutex_unlock(&q_lock);
+}
@@ -0,0 +1,249 @@
+#include "shmring/shmring.h"
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// 槽位起始地址
+static shmring_slot_t *slot_at(const uint8_t *base, const shmring_header_t *header, uint64_t seq) {
+    size_t index = (size_t)((seq - 1) % header->slot_count);
+    return (shmring_slot_t *)(base + SHMRING_HEADER_SIZE + index * header->slot_size);
+}
+
+// 跨进程 futex（共享映射，不能使用 FUTEX_PRIVATE_FLAG）
+static long futex(uint32_t *addr, int op, uint32_t val, const struct timespec *timeout) {
+    return syscall(SYS_futex, addr, op, val, timeout, NULL, 0);
+}
+
+// 创建（或重建）共享内存帧环
+int shmring_create(shmring_writer_t *ring, const char *name, uint32_t slot_count, uint32_t slot_size) {
+    memset(ring, 0, sizeof(shmring_writer_t));
+    ring->fd = -1;
+    if (!name || slot_count == 0 || slot_size <= SHMRING_SLOT_META) {
+        fprintf(stderr, "共享内存帧环参数无效\n");
+        return -1;
+    }
+    snprintf(ring->name, sizeof(ring->name), "%s", name);
+    ring->map_size = SHMRING_HEADER_SIZE + (size_t)slot_count * slot_size;
+
+    // 删除旧的帧环再新建：仍映射旧帧环的读者不会读到半初始化的数据
+    shm_unlink(ring->name);
+    ring->fd = shm_open(ring->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (ring->fd < 0) {
+        perror("共享内存创建失败");
+        return -1;
+    }
+    if (ftruncate(ring->fd, (off_t)ring->map_size) < 0) {
+        perror("共享内存大小设置失败");
+        shmring_destroy(ring);
+        return -1;
+    }
+    ring->base = (uint8_t *)mmap(NULL, ring->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+    if (ring->base == MAP_FAILED) {
+        perror("共享内存映射失败");
+        ring->base = NULL;
+        shmring_destroy(ring);
+        return -1;
+    }
+
+    // 新建的共享内存内容为零，最后写入魔数，读者据此判断环头已就绪
+    ring->header = (shmring_header_t *)ring->base;
+    ring->header->version = SHMRING_VERSION;
+    ring->header->slot_count = slot_count;
+    ring->header->slot_size = slot_size;
+    ring->header->writer_pid = (uint32_t)getpid();
+    __atomic_store_n(&ring->header->magic, SHMRING_MAGIC, __ATOMIC_RELEASE);
+
+    printf("共享内存帧环: %s, %u 槽位 x %u 字节\n", ring->name, slot_count, slot_size);
+    return 0;
+}
+
+// 写入一帧：序号锁置为奇数 -> 写数据 -> 序号锁置为偶数 -> 更新最新序号并唤醒读者
+int shmring_write(shmring_writer_t *ring, const shmring_frame_t *meta, const void *data, size_t len) {
+    shmring_header_t *header = ring->header;
+    shmring_slot_t *slot;
+    uint32_t lock;
+
+    if (!header) {
+        return -1;
+    }
+    if (len > header->slot_size - SHMRING_SLOT_META) {
+        ring->oversized++;
+        return -2;
+    }
+
+    uint64_t seq = ring->seq + 1;
+    slot = slot_at(ring->base, header, seq);
+    lock = slot->lock;
+    __atomic_store_n(&slot->lock, lock + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot->data_len = (uint32_t)len;
+    slot->seq = seq;
+    slot->capture_us = meta->capture_us;
+    slot->frame_id = meta->frame_id;
+    slot->width = meta->width;
+    slot->height = meta->height;
+    slot->pixel_format = meta->pixel_format;
+    slot->flags = meta->flags;
+    slot->palette_len = meta->palette_len;
+    slot->roi_x = meta->roi_x;
+    slot->roi_y = meta->roi_y;
+    slot->roi_width = meta->roi_width;
+    slot->roi_height = meta->roi_height;
+    slot->periph_width = meta->periph_width;
+    slot->periph_height = meta->periph_height;
+    memcpy((uint8_t *)slot + SHMRING_SLOT_META, data, len);
+
+    __atomic_store_n(&slot->lock, lock + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->head_seq, seq, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&header->notify, 1, __ATOMIC_RELEASE);
+    futex(&header->notify, FUTEX_WAKE, INT_MAX, NULL);
+    ring->seq = seq;
+    return 0;
+}
+
+// 删除共享内存并解除映射
+void shmring_destroy(shmring_writer_t *ring) {
+    if (ring->base) {
+        munmap(ring->base, ring->map_size);
+        ring->base = NULL;
+        ring->header = NULL;
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+        shm_unlink(ring->name);
+        ring->fd = -1;
+    }
+}
+
+// 以只读方式打开帧环
+int shmring_open(shmring_reader_t *reader, const char *name) {
+    struct stat st;
+
+    memset(reader, 0, sizeof(shmring_reader_t));
+    reader->fd = shm_open(name, O_RDONLY, 0);
+    if (reader->fd < 0) {
+        perror("共享内存打开失败");
+        return -1;
+    }
+    if (fstat(reader->fd, &st) < 0 || (size_t)st.st_size < SHMRING_HEADER_SIZE) {
+        fprintf(stderr, "共享内存帧环尚未就绪: %s\n", name);
+        shmring_close(reader);
+        return -1;
+    }
+    reader->map_size = (size_t)st.st_size;
+    reader->base = (const uint8_t *)mmap(NULL, reader->map_size, PROT_READ, MAP_SHARED, reader->fd, 0);
+    if (reader->base == MAP_FAILED) {
+        perror("共享内存映射失败");
+        reader->base = NULL;
+        shmring_close(reader);
+        return -1;
+    }
+
+    reader->header = (const shmring_header_t *)reader->base;
+    if (__atomic_load_n(&reader->header->magic, __ATOMIC_ACQUIRE) != SHMRING_MAGIC ||
+        reader->header->version != SHMRING_VERSION || reader->header->slot_count == 0 ||
+        SHMRING_HEADER_SIZE + (size_t)reader->header->slot_count * reader->header->slot_size > reader->map_size) {
+        fprintf(stderr, "共享内存帧环格式不匹配: %s\n", name);
+        shmring_close(reader);
+        return -1;
+    }
+
+    // 从打开之后的下一帧开始读取
+    reader->last_seq = __atomic_load_n(&reader->header->head_seq, __ATOMIC_ACQUIRE);
+    return 0;
+}
+
+// 等待新帧
+int shmring_wait(shmring_reader_t *reader, int timeout_ms) {
+    uint32_t *notify = (uint32_t *)&reader->header->notify;
+    uint32_t value = __atomic_load_n(notify, __ATOMIC_ACQUIRE);
+    struct timespec ts;
+
+    if (__atomic_load_n(&reader->header->head_seq, __ATOMIC_ACQUIRE) != reader->last_seq) {
+        return 1;
+    }
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000;
+    futex(notify, FUTEX_WAIT, value, timeout_ms < 0 ? NULL : &ts);
+    return __atomic_load_n(&reader->header->head_seq, __ATOMIC_ACQUIRE) != reader->last_seq;
+}
+
+// 取最新一帧（零拷贝）
+int shmring_read_latest(shmring_reader_t *reader, shmring_frame_t *frame) {
+    const shmring_header_t *header = reader->header;
+    const shmring_slot_t *slot;
+    uint64_t seq = __atomic_load_n(&header->head_seq, __ATOMIC_ACQUIRE);
+    uint32_t lock;
+
+    if (seq == 0 || seq == reader->last_seq) {
+        return -1;
+    }
+
+    slot = slot_at(reader->base, header, seq);
+    lock = __atomic_load_n(&slot->lock, __ATOMIC_ACQUIRE);
+    if (lock & 1) {
+        reader->torn++;
+        return -2;
+    }
+
+    frame->seq = slot->seq;
+    frame->lock = lock;
+    frame->frame_id = slot->frame_id;
+    frame->capture_us = slot->capture_us;
+    frame->width = slot->width;
+    frame->height = slot->height;
+    frame->pixel_format = slot->pixel_format;
+    frame->flags = slot->flags;
+    frame->palette_len = slot->palette_len;
+    frame->roi_x = slot->roi_x;
+    frame->roi_y = slot->roi_y;
+    frame->roi_width = slot->roi_width;
+    frame->roi_height = slot->roi_height;
+    frame->periph_width = slot->periph_width;
+    frame->periph_height = slot->periph_height;
+    frame->data_len = slot->data_len;
+    frame->data = (const uint8_t *)slot + SHMRING_SLOT_META;
+
+    // 读取记录头期间槽位被重写，或槽位已是更新一圈的帧
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&slot->lock, __ATOMIC_RELAXED) != lock || frame->seq != seq ||
+        frame->data_len > header->slot_size - SHMRING_SLOT_META) {
+        reader->torn++;
+        return -2;
+    }
+
+    if (reader->last_seq != 0 && seq > reader->last_seq + 1) {
+        reader->missed += seq - reader->last_seq - 1;
+    }
+    reader->last_seq = seq;
+    return 0;
+}
+
+// 使用完数据后确认未被覆盖
+bool shmring_frame_valid(const shmring_reader_t *reader, const shmring_frame_t *frame) {
+    const shmring_slot_t *slot = slot_at(reader->base, reader->header, frame->seq);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->lock, __ATOMIC_RELAXED) == frame->lock;
+}
+
+// 关闭读端
+void shmring_close(shmring_reader_t *reader) {
+    if (reader->base) {
+        munmap((void *)reader->base, reader->map_size);
+        reader->base = NULL;
+        reader->header = NULL;
+    }
+    if (reader->fd >= 0) {
+        close(reader->fd);
+        reader->fd = -1;
+    }
+}
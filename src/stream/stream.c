@@ -0,0 +1,100 @@
+#include "stream/stream.h"
+#include "camera/pixfmt.h"
+#include <string.h>
+#include <pthread.h>
+
+// 当前参数、待应用参数与最近一次重新配置结果
+static stream_config_t s_current;
+static stream_config_t s_pending;
+static bool s_has_pending = false;
+static uint64_t s_last_elapsed_us = 0;
+static int s_last_result = 0;
+static unsigned long s_reconfig_count = 0;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 设置当前生效的参数
+void stream_set_current(const stream_config_t *config) {
+    pthread_mutex_lock(&s_lock);
+    s_current = *config;
+    pthread_mutex_unlock(&s_lock);
+}
+
+// 获取当前生效的参数
+void stream_get_current(stream_config_t *config) {
+    pthread_mutex_lock(&s_lock);
+    *config = s_current;
+    pthread_mutex_unlock(&s_lock);
+}
+
+// 提交新的参数
+int stream_request(const stream_config_t *config) {
+    if (config->width < 16 || config->width > 1280 || config->height < 16 || config->height > 720 ||
+        config->capture_width < 160 || config->capture_width > 1920 ||
+        config->capture_height < 120 || config->capture_height > 1080 ||
+        config->crop_width < 0 || config->crop_width > config->capture_width ||
+        config->crop_height < 0 || config->crop_height > config->capture_height ||
+        (config->crop_width == 0) != (config->crop_height == 0) ||
+        config->roi_width < 0 || config->roi_width > config->width ||
+        config->roi_height < 0 || config->roi_height > config->height ||
+        (config->roi_width == 0) != (config->roi_height == 0) ||
+        config->fps < 1 || config->fps > 30 || config->qos < 0 || config->qos > 2 ||
+        config->pixel_format < 0 || config->pixel_format >= PIXEL_FORMAT_COUNT) {
+        fprintf(stderr, "视频流参数无效\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    s_pending = *config;
+    s_has_pending = true;
+    pthread_mutex_unlock(&s_lock);
+    printf("已登记视频流参数: %dx%d (采集 %dx%d, 裁剪 %dx%d, 注视区域 %dx%d), %d fps, QoS %d, %s%s\n",
+           config->width, config->height, config->capture_width, config->capture_height,
+           config->crop_width, config->crop_height, config->roi_width, config->roi_height,
+           config->fps, config->qos, pixfmt_name(config->pixel_format),
+           config->dither ? "+抖动" : "");
+    return 0;
+}
+
+// 取出待应用的参数
+bool stream_take_pending(stream_config_t *config) {
+    bool has = false;
+
+    pthread_mutex_lock(&s_lock);
+    if (s_has_pending) {
+        *config = s_pending;
+        s_has_pending = false;
+        has = true;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return has;
+}
+
+// 记录一次重新配置的结果
+void stream_report(const stream_config_t *config, uint64_t elapsed_us, int result) {
+    pthread_mutex_lock(&s_lock);
+    s_last_elapsed_us = elapsed_us;
+    s_last_result = result;
+    s_reconfig_count++;
+    pthread_mutex_unlock(&s_lock);
+
+    printf("视频流重新配置%s: %dx%d, %d fps, QoS %d, %s，耗时 %.2f ms\n",
+           result == 0 ? "完成" : (result == -2 ? "失败，摄像头已关闭" : "失败"), config->width, config->height,
+           config->fps, config->qos, pixfmt_name(config->pixel_format), elapsed_us / 1000.0);
+}
+
+// 打印当前参数与最近一次重新配置的结果
+void stream_print_status(void) {
+    pthread_mutex_lock(&s_lock);
+    printf("视频流: %dx%d (采集 %dx%d, 裁剪 %dx%d, 注视区域 %dx%d), %d fps, QoS %d, %s%s\n",
+           s_current.width, s_current.height, s_current.capture_width, s_current.capture_height,
+           s_current.crop_width, s_current.crop_height, s_current.roi_width, s_current.roi_height,
+           s_current.fps, s_current.qos, pixfmt_name(s_current.pixel_format),
+           s_current.dither ? "+抖动" : "");
+    if (s_reconfig_count > 0) {
+        printf("重新配置 %lu 次，最近一次%s，耗时 %.2f ms\n", s_reconfig_count,
+               s_last_result == 0 ? "成功" :
+               (s_last_result == -2 ? "失败且原配置无法恢复，摄像头已关闭" : "失败"),
+               s_last_elapsed_us / 1000.0);
+    }
+    pthread_mutex_unlock(&s_lock);
+}
@@ -0,0 +1,180 @@
+#include "thread_profile/thread_profile.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+// 各角色的线程放置配置（来自 config.h）
+static const thread_profile_t profiles[THREAD_ROLE_COUNT] = {
+    [THREAD_ROLE_CONTROL] = { "control", THREAD_CONTROL_POLICY, THREAD_CONTROL_PRIORITY, THREAD_CONTROL_CPUS },
+    [THREAD_ROLE_LISTEN]  = { "mqtt_listen", THREAD_LISTEN_POLICY, THREAD_LISTEN_PRIORITY, THREAD_LISTEN_CPUS },
+    [THREAD_ROLE_CAPTURE] = { "capture", THREAD_CAPTURE_POLICY, THREAD_CAPTURE_PRIORITY, THREAD_CAPTURE_CPUS },
+    [THREAD_ROLE_PUBLISH] = { "publish", THREAD_PUBLISH_POLICY, THREAD_PUBLISH_PRIORITY, THREAD_PUBLISH_CPUS },
+};
+
+static thread_profile_status_t statuses[THREAD_ROLE_COUNT];
+static pthread_mutex_t status_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 调度策略名称
+static const char *policy_name(int policy) {
+    switch (policy) {
+    case SCHED_FIFO:  return "SCHED_FIFO";
+    case SCHED_RR:    return "SCHED_RR";
+    case SCHED_OTHER: return "SCHED_OTHER";
+    default:          return "unknown";
+    }
+}
+
+// 设置调用线程的 nice 值（Linux 下 nice 作用于单个线程）
+static int set_thread_nice(int nice_value) {
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    return setpriority(PRIO_PROCESS, tid, nice_value);
+}
+
+// 读取调用线程的 nice 值
+static int get_thread_nice(void) {
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    errno = 0;
+    int value = getpriority(PRIO_PROCESS, tid);
+    return errno ? 0 : value;
+}
+
+// 初始化线程放置配置
+int thread_profile_init(bool lock_memory) {
+    int ret = 0;
+
+    pthread_mutex_lock(&status_lock);
+    memset(statuses, 0, sizeof(statuses));
+    pthread_mutex_unlock(&status_lock);
+
+    if (lock_memory) {
+        // 锁定当前及以后分配的内存，避免实时线程因缺页而抖动
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+            perror("mlockall失败，继续运行（可能缺少CAP_IPC_LOCK）");
+            ret = -1;
+        } else {
+            printf("已锁定进程内存\n");
+        }
+    }
+    return ret;
+}
+
+// 将角色配置应用到调用线程
+int thread_profile_apply(thread_role_t role) {
+    const thread_profile_t *profile;
+    thread_profile_status_t status;
+    struct sched_param param;
+    cpu_set_t cpus;
+    int policy;
+    int ret;
+
+    if (role < 0 || role >= THREAD_ROLE_COUNT) {
+        return -1;
+    }
+    profile = &profiles[role];
+    memset(&status, 0, sizeof(status));
+    pthread_setname_np(pthread_self(), profile->name);
+
+    // 调度策略与优先级
+    memset(&param, 0, sizeof(param));
+    if (profile->policy == SCHED_FIFO || profile->policy == SCHED_RR) {
+        param.sched_priority = profile->priority;
+        ret = pthread_setschedparam(pthread_self(), profile->policy, &param);
+        if (ret != 0) {
+            // 无 CAP_SYS_NICE 或 RLIMIT_RTPRIO 不足：退回普通调度并尽量提高 nice 优先级
+            fprintf(stderr, "线程 %s 设置 %s/%d 失败: %s，降级为 SCHED_OTHER\n",
+                    profile->name, policy_name(profile->policy), profile->priority, strerror(ret));
+            status.fallback = true;
+            if (set_thread_nice(-10) != 0) {
+                fprintf(stderr, "线程 %s 降级设置 nice=-10 失败: %s\n", profile->name, strerror(errno));
+            }
+        }
+    } else {
+        pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+        if (profile->priority != 0 && set_thread_nice(profile->priority) != 0) {
+            fprintf(stderr, "线程 %s 设置 nice=%d 失败: %s\n",
+                    profile->name, profile->priority, strerror(errno));
+            status.fallback = true;
+        }
+    }
+
+    // CPU亲和性：只保留实际在线的CPU，全部不在线时不做限制
+    if (profile->cpu_mask != 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        int count = 0;
+        CPU_ZERO(&cpus);
+        for (int i = 0; i < (int)(sizeof(unsigned long) * 8) && i < online; i++) {
+            if (profile->cpu_mask & (1UL << i)) {
+                CPU_SET(i, &cpus);
+                count++;
+            }
+        }
+        if (count == 0) {
+            fprintf(stderr, "线程 %s 的CPU掩码 0x%lx 不含在线CPU，忽略亲和性设置\n",
+                    profile->name, profile->cpu_mask);
+            status.fallback = true;
+        } else if ((ret = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)) != 0) {
+            fprintf(stderr, "线程 %s 设置CPU亲和性失败: %s\n", profile->name, strerror(ret));
+            status.fallback = true;
+        }
+    }
+
+    // 读回内核实际设置，作为可观测的核对依据
+    if (pthread_getschedparam(pthread_self(), &policy, &param) == 0) {
+        status.policy = policy;
+        status.priority = (policy == SCHED_OTHER) ? get_thread_nice() : param.sched_priority;
+    }
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0) {
+        for (int i = 0; i < (int)(sizeof(unsigned long) * 8); i++) {
+            if (CPU_ISSET(i, &cpus)) {
+                status.cpu_mask |= 1UL << i;
+            }
+        }
+    }
+    if (status.policy != profile->policy) {
+        status.fallback = true;
+    }
+    status.applied = true;
+
+    pthread_mutex_lock(&status_lock);
+    statuses[role] = status;
+    pthread_mutex_unlock(&status_lock);
+
+    printf("线程 %s: %s/%d, CPU 0x%lx%s\n", profile->name, policy_name(status.policy),
+           status.priority, status.cpu_mask, status.fallback ? " (已降级)" : " (已生效)");
+    return status.fallback ? 1 : 0;
+}
+
+// 获取角色的配置生效情况
+void thread_profile_get_status(thread_role_t role, thread_profile_status_t *status) {
+    if (!status || role < 0 || role >= THREAD_ROLE_COUNT) {
+        return;
+    }
+    pthread_mutex_lock(&status_lock);
+    *status = statuses[role];
+    pthread_mutex_unlock(&status_lock);
+}
+
+// 打印所有角色的配置与实际生效情况
+void thread_profile_print(void) {
+    printf("线程放置配置（期望 -> 实际）:\n");
+    pthread_mutex_lock(&status_lock);
+    for (int i = 0; i < THREAD_ROLE_COUNT; i++) {
+        const thread_profile_t *p = &profiles[i];
+        const thread_profile_status_t *s = &statuses[i];
+        if (!s->applied) {
+            printf("  %-12s %s/%d CPU 0x%lx -> 未启动\n",
+                   p->name, policy_name(p->policy), p->priority, p->cpu_mask);
+            continue;
+        }
+        printf("  %-12s %s/%d CPU 0x%lx -> %s/%d CPU 0x%lx%s\n",
+               p->name, policy_name(p->policy), p->priority, p->cpu_mask,
+               policy_name(s->policy), s->priority, s->cpu_mask,
+               s->fallback ? " (已降级)" : "");
+    }
+    pthread_mutex_unlock(&status_lock);
+}
@@ -0,0 +1,210 @@
+#include "trace/trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+
+// 单个事件（名称只保存指针，须为字符串常量）
+typedef struct {
+    uint64_t ts_ns;        // CLOCK_MONOTONIC 纳秒
+    const char *name;
+    char phase;
+} trace_event_t;
+
+// 线程缓冲区：只有所属线程写入，head 为累计写入数
+typedef struct {
+    pid_t tid;
+    char thread_name[16];
+    uint32_t head;
+    trace_event_t events[TRACE_BUFFER_EVENTS];
+} trace_buffer_t;
+
+volatile int trace_active = 0;
+
+static char trace_path[256];
+static int notify_fd = -1;
+static trace_buffer_t *buffers[TRACE_MAX_THREADS];
+static int buffer_count = 0;
+static bool buffers_full_warned = false;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread trace_buffer_t *local_buffer = NULL;
+static __thread bool local_untraced = false; // 线程数超过上限，本线程不记录
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// 为调用线程分配缓冲区（每个线程只执行一次）
+static trace_buffer_t *register_thread(void) {
+    trace_buffer_t *buffer = NULL;
+
+    pthread_mutex_lock(&trace_lock);
+    if (buffer_count < TRACE_MAX_THREADS) {
+        buffer = (trace_buffer_t *)calloc(1, sizeof(trace_buffer_t));
+        if (buffer) {
+            buffer->tid = (pid_t)syscall(SYS_gettid);
+            pthread_getname_np(pthread_self(), buffer->thread_name, sizeof(buffer->thread_name));
+            buffers[buffer_count++] = buffer;
+        }
+    } else if (!buffers_full_warned) {
+        fprintf(stderr, "追踪线程数超过 %d，新线程不再记录\n", TRACE_MAX_THREADS);
+        buffers_full_warned = true;
+    }
+    pthread_mutex_unlock(&trace_lock);
+
+    if (!buffer) {
+        local_untraced = true;
+    }
+    return buffer;
+}
+
+// 开始记录
+int trace_init(const char *path) {
+    if (!TRACE_ENABLE) {
+        fprintf(stderr, "编译时未启用追踪（TRACE_ENABLE=0）\n");
+        return -1;
+    }
+    if (!path || strlen(path) >= sizeof(trace_path)) {
+        fprintf(stderr, "追踪导出路径无效\n");
+        return -1;
+    }
+    snprintf(trace_path, sizeof(trace_path), "%s", path);
+
+    notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (notify_fd < 0) {
+        perror("追踪eventfd创建失败");
+        return -1;
+    }
+    trace_active = 1;
+    printf("事件追踪已启用，导出到 %s（每线程 %d 个事件）\n", trace_path, TRACE_BUFFER_EVENTS);
+    return 0;
+}
+
+// 记录一个事件
+void trace_record(const char *name, char phase) {
+    trace_buffer_t *buffer = local_buffer;
+
+    if (!buffer) {
+        if (local_untraced || !(buffer = register_thread())) {
+            return;
+        }
+        local_buffer = buffer;
+    }
+
+    uint32_t head = buffer->head;
+    trace_event_t *event = &buffer->events[head % TRACE_BUFFER_EVENTS];
+    event->ts_ns = now_ns();
+    event->name = name;
+    event->phase = phase;
+    __atomic_store_n(&buffer->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// 请求导出（信号安全）
+void trace_request_dump(void) {
+    uint64_t one = 1;
+    if (notify_fd >= 0) {
+        ssize_t ret = write(notify_fd, &one, sizeof(one));
+        (void)ret;
+    }
+}
+
+int trace_notify_fd(void) {
+    return notify_fd;
+}
+
+// 处理导出请求
+void trace_handle_notify(void) {
+    uint64_t count;
+    if (read(notify_fd, &count, sizeof(count)) == sizeof(count)) {
+        trace_dump();
+    }
+}
+
+// 写入一个线程缓冲区中的事件，返回事件数
+static int dump_buffer(FILE *fp, const trace_buffer_t *buffer, pid_t pid, bool *first) {
+    uint32_t head = __atomic_load_n(&buffer->head, __ATOMIC_ACQUIRE);
+    uint32_t start = head > TRACE_BUFFER_EVENTS ? head - TRACE_BUFFER_EVENTS : 0;
+    int count = 0;
+
+    fprintf(fp, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            *first ? "" : ",", (int)pid, (int)buffer->tid,
+            buffer->thread_name[0] ? buffer->thread_name : "thread");
+    *first = false;
+
+    // 缓冲区已回绕时，开头的结束事件对应的开始事件已被覆盖，跳过
+    while (start != head && buffer->events[start % TRACE_BUFFER_EVENTS].phase == 'E' && head > TRACE_BUFFER_EVENTS) {
+        start++;
+    }
+    for (uint32_t i = start; i != head; i++) {
+        const trace_event_t *event = &buffer->events[i % TRACE_BUFFER_EVENTS];
+        fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":%d,\"tid\":%d%s}",
+                event->name, event->phase,
+                (unsigned long long)(event->ts_ns / 1000), (unsigned)(event->ts_ns % 1000),
+                (int)pid, (int)buffer->tid, event->phase == 'i' ? ",\"s\":\"t\"" : "");
+        count++;
+    }
+    return count;
+}
+
+// 导出 Chrome trace JSON：先写临时文件再改名，导出中途退出不会留下残缺文件
+int trace_dump(void) {
+    char tmp_path[sizeof(trace_path) + 8];
+    pid_t pid = getpid();
+    bool first = true;
+    int total = 0;
+    FILE *fp;
+
+    if (!trace_path[0]) {
+        return -1;
+    }
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", trace_path);
+    fp = fopen(tmp_path, "w");
+    if (!fp) {
+        perror("追踪文件创建失败");
+        return -1;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    pthread_mutex_lock(&trace_lock);
+    for (int i = 0; i < buffer_count; i++) {
+        total += dump_buffer(fp, buffers[i], pid, &first);
+    }
+    pthread_mutex_unlock(&trace_lock);
+    fprintf(fp, "\n]}\n");
+
+    if (fclose(fp) != 0 || rename(tmp_path, trace_path) != 0) {
+        perror("追踪文件写入失败");
+        unlink(tmp_path);
+        return -1;
+    }
+    printf("已导出 %d 个追踪事件到 %s\n", total, trace_path);
+    return total;
+}
+
+// 停止记录并释放缓冲区
+void trace_shutdown(void) {
+    if (!trace_active) {
+        return;
+    }
+    trace_dump();
+    trace_active = 0;
+
+    pthread_mutex_lock(&trace_lock);
+    for (int i = 0; i < buffer_count; i++) {
+        free(buffers[i]);
+        buffers[i] = NULL;
+    }
+    buffer_count = 0;
+    pthread_mutex_unlock(&trace_lock);
+
+    if (notify_fd >= 0) {
+        close(notify_fd);
+        notify_fd = -1;
+    }
+}